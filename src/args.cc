@@ -10,6 +10,21 @@ namespace poincare {
 Args::Args() {
     additive_updates = false;
     verbose = false;
+    huge_pages = false;
+    lock_free = false;
+    ordered_locking = false;
+    partitions = 0;
+    max_negative_attempts = 100;
+    shuffle = ShuffleMode::NONE;
+    shuffle_block = 4096;
+    relabel = RelabelMode::NONE;
+    group_by_source = false;
+    per_edge_source_updates = false;
+    batch_size = 0;
+    sampler_threads = 0;
+    lock_table = LockTableMode::BYTE;
+    lock_stripes = 65536;
+    precision = Precision::LONG_DOUBLE;
     start_lr = 0.05;
     end_lr = 0.05;
     max_step_size = 2;
@@ -37,6 +52,8 @@ void Args::parse_args(const std::vector<std::string>& args) {
                 exit(EXIT_FAILURE);
             } else if (args[ai] == "-graph") {
                 graph = std::string(args.at(ai + 1));
+            } else if (args[ai] == "-graph-cache") {
+                graph_cache = std::string(args.at(ai + 1));
             } else if (args[ai] == "-input-vectors") {
                 input_vectors = std::string(args.at(ai + 1));
             } else if (args[ai] == "-output-vectors") {
@@ -67,6 +84,82 @@ void Args::parse_args(const std::vector<std::string>& args) {
                 verbose = std::stoi(args.at(ai + 1));
             } else if (args[ai] == "-retraction-updates") {
                 additive_updates = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-huge-pages") {
+                huge_pages = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-lock-free") {
+                lock_free = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-ordered-locking") {
+                ordered_locking = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-partitions") {
+                partitions = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-max-negative-attempts") {
+                max_negative_attempts = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-shuffle") {
+                std::string name = args.at(ai + 1);
+                if (name == shuffle_name(ShuffleMode::NONE)) {
+                    shuffle = ShuffleMode::NONE;
+                } else if (name == shuffle_name(ShuffleMode::BLOCKED)) {
+                    shuffle = ShuffleMode::BLOCKED;
+                } else if (name == shuffle_name(ShuffleMode::FULL)) {
+                    shuffle = ShuffleMode::FULL;
+                } else {
+                    std::cerr << "Unknown shuffle: " << name << std::endl;
+                    print_help();
+                    exit(EXIT_FAILURE);
+                }
+            } else if (args[ai] == "-shuffle-block") {
+                shuffle_block = std::stoll(args.at(ai + 1));
+            } else if (args[ai] == "-relabel") {
+                std::string name = args.at(ai + 1);
+                if (name == relabel_name(RelabelMode::NONE)) {
+                    relabel = RelabelMode::NONE;
+                } else if (name == relabel_name(RelabelMode::BREADTH_FIRST)) {
+                    relabel = RelabelMode::BREADTH_FIRST;
+                } else if (name == relabel_name(RelabelMode::DEPTH_FIRST)) {
+                    relabel = RelabelMode::DEPTH_FIRST;
+                } else if (name == relabel_name(RelabelMode::DEGREE)) {
+                    relabel = RelabelMode::DEGREE;
+                } else {
+                    std::cerr << "Unknown relabelling: " << name << std::endl;
+                    print_help();
+                    exit(EXIT_FAILURE);
+                }
+            } else if (args[ai] == "-group-by-source") {
+                group_by_source = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-per-edge-source-updates") {
+                per_edge_source_updates = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-batch-size") {
+                batch_size = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-sampler-threads") {
+                sampler_threads = std::stoi(args.at(ai + 1));
+            } else if (args[ai] == "-lock-table") {
+                std::string name = args.at(ai + 1);
+                if (name == lock_table_name(LockTableMode::BIT)) {
+                    lock_table = LockTableMode::BIT;
+                } else if (name == lock_table_name(LockTableMode::BYTE)) {
+                    lock_table = LockTableMode::BYTE;
+                } else if (name == lock_table_name(LockTableMode::STRIPED)) {
+                    lock_table = LockTableMode::STRIPED;
+                } else {
+                    std::cerr << "Unknown lock table: " << name << std::endl;
+                    print_help();
+                    exit(EXIT_FAILURE);
+                }
+            } else if (args[ai] == "-lock-stripes") {
+                lock_stripes = std::stoll(args.at(ai + 1));
+            } else if (args[ai] == "-precision") {
+                std::string name = args.at(ai + 1);
+                if (name == precision_name(Precision::FLOAT)) {
+                    precision = Precision::FLOAT;
+                } else if (name == precision_name(Precision::DOUBLE)) {
+                    precision = Precision::DOUBLE;
+                } else if (name == precision_name(Precision::LONG_DOUBLE)) {
+                    precision = Precision::LONG_DOUBLE;
+                } else {
+                    std::cerr << "Unknown precision: " << name << std::endl;
+                    print_help();
+                    exit(EXIT_FAILURE);
+                }
             } else {
                 std::cerr << "Unknown argument: " << args[ai] << std::endl;
                 print_help();
@@ -78,6 +171,61 @@ void Args::parse_args(const std::vector<std::string>& args) {
             exit(EXIT_FAILURE);
         }
     }
+    if (int(lock_free) + int(ordered_locking) + int(partitions > 0) > 1) {
+        std::cerr << "Only one of -lock-free, -ordered-locking and -partitions can be used." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (partitions < 0) {
+        std::cerr << "-partitions must not be negative." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (shuffle != ShuffleMode::NONE && partitions > 0) {
+        std::cerr << "-shuffle can not be used with -partitions." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (group_by_source && (ordered_locking || partitions > 0 || shuffle != ShuffleMode::NONE)) {
+        std::cerr << "-group-by-source can not be used with -ordered-locking, -partitions or -shuffle." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (batch_size < 0) {
+        std::cerr << "-batch-size must not be negative." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (batch_size > 0 && (partitions > 0 || group_by_source)) {
+        std::cerr << "-batch-size can not be used with -partitions or -group-by-source." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (sampler_threads < 0) {
+        std::cerr << "-sampler-threads must not be negative." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (sampler_threads > 0 && (partitions > 0 || group_by_source || batch_size > 0)) {
+        std::cerr << "-sampler-threads can not be used with -partitions, -group-by-source or -batch-size." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (shuffle_block <= 0) {
+        std::cerr << "-shuffle-block must be positive." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (lock_stripes <= 0) {
+        std::cerr << "-lock-stripes must be positive." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
+    if (max_negative_attempts <= 0) {
+        std::cerr << "-max-negative-attempts must be positive." << std::endl;
+        print_help();
+        exit(EXIT_FAILURE);
+    }
     if (graph.empty() || output_vectors.empty()) {
         std::cerr << "Empty graph or output-vectors path." << std::endl;
         print_help();
@@ -88,6 +236,7 @@ void Args::parse_args(const std::vector<std::string>& args) {
 void Args::print_help() {
     std::cerr
         << "    -graph                      training file path\n"
+        << "    -graph-cache                file path for a binary copy of the parsed graph, rebuilt if stale (optional)\n"
         << "    -output-vectors             file path for trained vectors\n"
         << "    -input-vectors              file path for init vectors (optional)\n"
         << "    -retraction-updates         use the retraction updates of Nickel & Kiela (0 or 1) [" << int(additive_updates) << "]\n"
@@ -103,6 +252,67 @@ void Args::print_help() {
         << "    -checkpoint-interval        save vectors every this many epochs [" << checkpoint_interval << "]\n"
         << "    -threads                    number of threads [" << threads << "]\n"
         << "    -seed                       seed for the random number generator [" << seed << "]\n"
-        << "                                  n.b. only deterministic if single threaded!\n";
+        << "                                  n.b. only deterministic if single threaded!\n"
+        << "    -huge-pages                 back the vectors with transparent huge pages (0 or 1) [" << int(huge_pages) << "]\n"
+        << "    -lock-free                  train without locks, storing the vectors on the ball (0 or 1) [" << int(lock_free) << "]\n"
+        << "    -ordered-locking            wait for locks (in a fixed order) instead of skipping edges (0 or 1) [" << int(ordered_locking) << "]\n"
+        << "    -partitions                 train without locks, in rounds of disjoint partitions of the nodes (0 for off) [" << partitions << "]\n"
+        << "    -max-negative-attempts      draws per negative sample before training an edge with fewer [" << max_negative_attempts << "]\n"
+        << "    -shuffle                    order of the edges in each epoch: none, blocked or full [" << shuffle_name(shuffle) << "]\n"
+        << "    -shuffle-block              number of edges per block for -shuffle blocked [" << shuffle_block << "]\n"
+        << "    -relabel                    renumber the nodes for locality: none, bfs, dfs or degree [" << relabel_name(relabel) << "]\n"
+        << "    -group-by-source            train the edges of each source together, holding its vector throughout (0 or 1) [" << int(group_by_source) << "]\n"
+        << "    -per-edge-source-updates    with -group-by-source, update the source after each edge, not once per source (0 or 1) [" << int(per_edge_source_updates) << "]\n"
+        << "    -batch-size                 train mini-batches of this many edges, sharing -number-negatives negatives (0 for off) [" << batch_size << "]\n"
+        << "    -sampler-threads            threads drawing the negatives ahead of the training threads (0 for off) [" << sampler_threads << "]\n"
+        << "    -lock-table                 per-node locks: bit, byte or striped [" << lock_table_name(lock_table) << "]\n"
+        << "    -lock-stripes               number of locks for -lock-table striped [" << lock_stripes << "]\n"
+        << "    -precision                  scalar type: float, double or long-double [" << precision_name(precision) << "]\n";
+}
+
+std::string Args::precision_name(Precision p) {
+    switch (p) {
+        case Precision::FLOAT:
+            return "float";
+        case Precision::DOUBLE:
+            return "double";
+        default:
+            return "long-double";
+    }
+}
+
+std::string Args::lock_table_name(LockTableMode mode) {
+    switch (mode) {
+        case LockTableMode::BIT:
+            return "bit";
+        case LockTableMode::STRIPED:
+            return "striped";
+        default:
+            return "byte";
+    }
+}
+
+std::string Args::shuffle_name(ShuffleMode mode) {
+    switch (mode) {
+        case ShuffleMode::BLOCKED:
+            return "blocked";
+        case ShuffleMode::FULL:
+            return "full";
+        default:
+            return "none";
+    }
+}
+
+std::string Args::relabel_name(RelabelMode mode) {
+    switch (mode) {
+        case RelabelMode::BREADTH_FIRST:
+            return "bfs";
+        case RelabelMode::DEPTH_FIRST:
+            return "dfs";
+        case RelabelMode::DEGREE:
+            return "degree";
+        default:
+            return "none";
+    }
 }
 }
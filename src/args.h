@@ -5,10 +5,48 @@
 
 namespace poincare {
 
+/**
+ * Scalar type used for the vectors and all training computations.
+ */
+enum class Precision {
+    FLOAT,
+    DOUBLE,
+    LONG_DOUBLE
+};
+
+/**
+ * Layout of the table of per-node locks (see locks.h).
+ */
+enum class LockTableMode {
+    BIT,
+    BYTE,
+    STRIPED
+};
+
+/**
+ * The order in which the edges are trained in each epoch.
+ */
+enum class ShuffleMode {
+    NONE, // the order of the training file
+    BLOCKED, // shuffled blocks of edges, each shuffled (see shuffle.h)
+    FULL // a uniformly random permutation
+};
+
+/**
+ * The enumeration of the nodes used for training (see relabel.h).
+ */
+enum class RelabelMode {
+    NONE, // order of first appearance in the training file
+    BREADTH_FIRST,
+    DEPTH_FIRST,
+    DEGREE
+};
+
 class Args {
     public:
         Args();
         std::string graph;
+        std::string graph_cache;
         std::string input_vectors;
         std::string output_vectors;
         double max_step_size;
@@ -24,8 +62,43 @@ class Args {
         double init_std_dev;
         bool additive_updates;
         bool verbose;
+        bool huge_pages;
+        bool lock_free;
+        bool ordered_locking;
+        int partitions;
+        int max_negative_attempts;
+        ShuffleMode shuffle;
+        int64_t shuffle_block;
+        RelabelMode relabel;
+        bool group_by_source;
+        bool per_edge_source_updates;
+        int batch_size;
+        int sampler_threads;
+        LockTableMode lock_table;
+        int64_t lock_stripes;
+        Precision precision;
 
     void parse_args(const std::vector<std::string>& args);
     void print_help();
+
+    /**
+     * Return the name of the precision, as accepted by -precision.
+     */
+    static std::string precision_name(Precision);
+
+    /**
+     * Return the name of the lock table mode, as accepted by -lock-table.
+     */
+    static std::string lock_table_name(LockTableMode);
+
+    /**
+     * Return the name of the shuffle mode, as accepted by -shuffle.
+     */
+    static std::string shuffle_name(ShuffleMode);
+
+    /**
+     * Return the name of the relabelling, as accepted by -relabel.
+     */
+    static std::string relabel_name(RelabelMode);
 };
 }
@@ -0,0 +1,19 @@
+#include "barrier.h"
+
+namespace poincare {
+
+Barrier::Barrier(int32_t count) : count_(count), waiting_(0), generation_(0) {}
+
+void Barrier::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int64_t generation = generation_;
+    if (++waiting_ == count_) {
+        waiting_ = 0;
+        generation_++;
+        condition_.notify_all();
+        return;
+    }
+    condition_.wait(lock, [this, generation]() { return generation_ != generation; });
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace poincare {
+
+class Barrier {
+    /**
+     * A reusable barrier for a fixed number of threads: each call to wait()
+     * blocks until all the threads have called it.
+     */
+
+    public:
+        explicit Barrier(int32_t count);
+
+        Barrier(const Barrier&) = delete;
+        Barrier& operator=(const Barrier&) = delete;
+
+        void wait();
+
+    protected:
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        const int32_t count_;
+        int32_t waiting_;
+        int64_t generation_;
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string.h>
+#include <vector>
+
+namespace poincare {
+
+/**
+ * Helpers for binary files of plain values and arrays of them, in the byte
+ * order of this machine.    Reading is from memory (e.g. a mapped file), from
+ * `cursor` up to `end`, advancing `cursor` past what was read; the readers
+ * return false (and read nothing) if there are too few bytes left.
+ */
+
+template <typename T>
+void write_value(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(const char*& cursor, const char* end, T& value) {
+    if (end - cursor < int64_t(sizeof(T))) {
+        return false;
+    }
+    memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+/**
+ * Write the number of elements of `values` and then the elements.
+ */
+template <typename T>
+void write_array(std::ostream& out, const std::vector<T>& values) {
+    write_value(out, int64_t(values.size()));
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool read_array(const char*& cursor, const char* end, std::vector<T>& values) {
+    const char* start = cursor;
+    int64_t size;
+    if (!read_value(cursor, end, size) || size < 0 || (end - cursor) / int64_t(sizeof(T)) < size) {
+        cursor = start;
+        return false;
+    }
+    values.resize(size);
+    if (size > 0) {
+        memcpy(values.data(), cursor, size * sizeof(T));
+    }
+    cursor += size * sizeof(T);
+    return true;
+}
+
+}
@@ -1,56 +1,316 @@
 #include "digraph.h"
+#include "binary_io.h"
 #include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+
+// the least number of bytes of the file per parsing thread
+constexpr int64_t MIN_CHUNK_BYTES = 1 << 20;
+// the first bytes of a graph cache file, and the version of its format
+// (followed by the size of the enumeration of the nodes, see node.h)
+const char CACHE_MAGIC[8] = {'P', 'G', 'R', 'A', 'P', 'H', 'C', '\0'};
+constexpr uint32_t CACHE_VERSION = 3;
 
 namespace poincare {
     const char SEPARATOR = '\t';
 
+namespace {
+
+/**
+ * The result of scanning one chunk of the file: the names it mentions, in
+ * order of first appearance, and its edges, as pairs of indices into these.
+ */
+struct ChunkGraph {
+    ChunkGraph() : lines(0), bad_line(-1) {}
+    NameTable names;
+    std::vector<std::pair<node_t, node_t>> edges;
+    // the number of lines scanned, and the index among these of the first
+    // that does not have two columns (-1 if none)
+    int64_t lines;
+    int64_t bad_line;
+};
+
+/**
+ * Scan the lines of [begin, end), which should start at the beginning of a
+ * line, into `chunk`, stopping at the first malformed line.    The fields of
+ * a line are split as by std::getline with SEPARATOR (so that a separator at
+ * the end of the line does not start another field).
+ */
+void scan_chunk(const char* begin, const char* end, ChunkGraph& chunk) {
+    for (const char* line = begin; line < end; chunk.lines++) {
+        const char* line_end = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        const char* tab = static_cast<const char*>(memchr(line, SEPARATOR, line_end - line));
+        const char* second_tab = tab == nullptr ? nullptr
+            : static_cast<const char*>(memchr(tab + 1, SEPARATOR, line_end - tab - 1));
+        if (tab == nullptr || tab + 1 == line_end || (second_tab != nullptr && second_tab + 1 != line_end)) {
+            chunk.bad_line = chunk.lines;
+            return;
+        }
+        node_t source = chunk.names.insert(line, tab - line);
+        node_t target = chunk.names.insert(tab + 1, (second_tab == nullptr ? line_end : second_tab) - tab - 1);
+        chunk.edges.push_back(std::make_pair(source, target));
+        line = line_end + 1;
+    }
+}
+
+/**
+ * The contents of a file, mapped into memory (read-only) for as long as this
+ * exists.
+ */
+class MappedFile {
+    public:
+        MappedFile(const std::string& filename) : data_(nullptr), size_(0) {
+            int fd = open(filename.c_str(), O_RDONLY);
+            struct stat info;
+            if (fd < 0 || fstat(fd, &info) != 0) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                throw std::invalid_argument(filename + " cannot be opened!");
+            }
+            size_ = info.st_size;
+            if (size_ > 0) {
+                void* ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ptr == MAP_FAILED) {
+                    close(fd);
+                    throw std::invalid_argument(filename + " cannot be mapped into memory!");
+                }
+                madvise(ptr, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(ptr);
+            }
+            close(fd);
+        }
+
+        ~MappedFile() {
+            if (data_ != nullptr) {
+                munmap(const_cast<char*>(data_), size_);
+            }
+        }
+
+        const char* data() const { return data_; }
+        int64_t size() const { return size_; }
+
+    private:
+        const char* data_;
+        int64_t size_;
+};
+
+}
+
+Digraph::Digraph(const std::string& filename, int32_t threads, const std::string& cache_filename) {
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0) {
+        throw std::invalid_argument(filename + " cannot be opened!");
+    }
+    const int64_t source_size = info.st_size;
+    const int64_t source_mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    if (read_cache(cache_filename, source_size, source_mtime)) {
+        std::cerr << "Read " << edge_count() << " edges from the graph cache " << cache_filename << "." << std::endl;
+        std::cerr << "Number of nodes: " << node_count() << std::endl;
+        return;
+    }
+    MappedFile file(filename);
+    parse(file.data(), file.size(), threads);
+    if (write_cache(cache_filename, source_size, source_mtime)) {
+        std::cerr << "Wrote the graph cache " << cache_filename << "." << std::endl;
+    } else {
+        std::cerr << "Could not write the graph cache " << cache_filename << "!" << std::endl;
+    }
+}
+
 Digraph::Digraph(std::istream& in) {
-    std::string line;
-    std::vector<std::string> fields;
-    std::string field;
-    while (std::getline(in, line)) {
-        std::stringstream line_stream(line);
-        fields.clear();
-        while (std::getline(line_stream, field, '\t')) {
-            fields.push_back(field);
-        }
-        if (fields.size() != 2) {
-            throw std::runtime_error("expected exactly two tab-separated columns at line " + std::to_string(edges.size()));
-        }
-        Node& source = find_or_create_node(fields[0]);
-        Node& target = find_or_create_node(fields[1]);
-        Edge* edge_ptr = new Edge(source, target);
-        edges.push_back(edge_ptr);
-    }
-    std::cerr << "\rRead " << edges.size() << " edges." << std::endl;
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    parse(contents.data(), contents.size(), 1);
+}
+
+Digraph::Digraph(const std::string& filename, int32_t threads) {
+    MappedFile file(filename);
+    parse(file.data(), file.size(), threads);
+}
+
+void Digraph::parse(const char* data, int64_t size, int32_t threads) {
+    // split into chunks at line boundaries, and scan them in parallel
+    threads = std::max<int64_t>(1, std::min<int64_t>(threads, size / MIN_CHUNK_BYTES));
+    std::vector<const char*> bounds(1, data);
+    for (int32_t t = 1; t < threads; t++) {
+        const char* bound = std::max(data + size * t / threads, bounds.back());
+        const char* newline = static_cast<const char*>(memchr(bound, '\n', data + size - bound));
+        bounds.push_back(newline == nullptr ? data + size : newline + 1);
+    }
+    bounds.push_back(data + size);
+    std::vector<ChunkGraph> chunks(threads);
+    std::vector<std::thread> workers;
+    for (int32_t t = 1; t < threads; t++) {
+        workers.push_back(std::thread(scan_chunk, bounds[t], bounds[t + 1], std::ref(chunks[t])));
+    }
+    scan_chunk(bounds[0], bounds[1], chunks[0]);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    // merge in file order, so that the nodes are enumerated in order of first
+    // appearance in the file, as if it were read sequentially
+    int64_t lines = 0;
+    for (const ChunkGraph& chunk : chunks) {
+        if (chunk.bad_line >= 0) {
+            throw std::runtime_error("expected exactly two tab-separated columns at line " + std::to_string(lines + chunk.bad_line));
+        }
+        lines += chunk.lines;
+    }
+    int64_t total_edges = 0;
+    int64_t most_names = 0;
+    for (const ChunkGraph& chunk : chunks) {
+        total_edges += chunk.edges.size();
+        most_names = std::max(most_names, chunk.names.size());
+    }
+    edge_sources.reserve(total_edges);
+    edge_targets.reserve(total_edges);
+    names.reserve(most_names);
+    std::vector<node_t> nodes;
+    for (ChunkGraph& chunk : chunks) {
+        nodes.clear();
+        for (node_t i = 0; i < chunk.names.size(); i++) {
+            nodes.push_back(names.insert(chunk.names.data(i), chunk.names.length(i)));
+        }
+        for (const std::pair<node_t, node_t>& edge : chunk.edges) {
+            edge_sources.push_back(nodes[edge.first]);
+            edge_targets.push_back(nodes[edge.second]);
+        }
+        // free the chunk as we go
+        chunk = ChunkGraph();
+    }
+    build_adjacency();
+    std::cerr << "\rRead " << edge_count() << " edges." << std::endl;
     std::cerr << "Number of nodes: " << node_count() << std::endl;
 }
 
-Digraph::~Digraph() {
-    for (int32_t i=0; i < edges.size(); i++) {
-        delete edges[i];
+void Digraph::relabel(const std::vector<node_t>& order) {
+    const int64_t nodes = node_count();
+    assert(int64_t(order.size()) == nodes);
+    std::vector<node_t> new_nodes(nodes);
+    NameTable new_names;
+    new_names.reserve(nodes);
+    for (node_t k = 0; k < nodes; k++) {
+        new_nodes[order[k]] = k;
+        new_names.insert(names.data(order[k]), names.length(order[k]));
+    }
+    names = std::move(new_names);
+    for (int64_t i = 0; i < edge_count(); i++) {
+        edge_sources[i] = new_nodes[edge_sources[i]];
+        edge_targets[i] = new_nodes[edge_targets[i]];
     }
-    for (int32_t i=0; i < enumeration2node.size(); i++) {
-        delete enumeration2node[i];
+    // the file order, in terms of the new nodes
+    if (file_order.empty()) {
+        file_order = new_nodes;
+    } else {
+        for (node_t& node : file_order) {
+            node = new_nodes[node];
+        }
     }
+    build_adjacency();
 }
 
-int64_t const Digraph::node_count() {
-    return enumeration2node.size();
+void Digraph::build_adjacency() {
+    const int64_t nodes = node_count();
+    count_as_source.assign(nodes, 0);
+    count_as_target.assign(nodes, 0);
+    for (int64_t i = 0; i < edge_count(); i++) {
+        count_as_source[edge_sources[i]]++;
+        count_as_target[edge_targets[i]]++;
+    }
+    // a counting sort of the edges by source, keeping their order
+    target_offsets.assign(nodes + 1, 0);
+    for (int64_t n = 0; n < nodes; n++) {
+        target_offsets[n + 1] = target_offsets[n] + count_as_source[n];
+    }
+    std::vector<int64_t> cursors(target_offsets.begin(), target_offsets.end() - 1);
+    target_enums.resize(edge_count());
+    for (int64_t i = 0; i < edge_count(); i++) {
+        target_enums[cursors[edge_sources[i]]++] = edge_targets[i];
+    }
+}
+
+bool Digraph::read_cache(const std::string& cache_filename, int64_t source_size, int64_t source_mtime) {
+    struct stat info;
+    if (stat(cache_filename.c_str(), &info) != 0) {
+        return false;
+    }
+    MappedFile file(cache_filename);
+    const char* cursor = file.data();
+    const char* end = cursor + file.size();
+    uint32_t version, node_bytes;
+    int64_t size, mtime;
+    if (file.size() < int64_t(sizeof(CACHE_MAGIC)) || memcmp(cursor, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        return false;
+    }
+    cursor += sizeof(CACHE_MAGIC);
+    if (!read_value(cursor, end, version) || version != CACHE_VERSION
+            || !read_value(cursor, end, node_bytes) || node_bytes != sizeof(node_t)
+            || !read_value(cursor, end, size) || size != source_size
+            || !read_value(cursor, end, mtime) || mtime != source_mtime) {
+        return false;
+    }
+    bool valid = names.read(cursor, end)
+        && read_array(cursor, end, edge_sources) && read_array(cursor, end, edge_targets)
+        && read_array(cursor, end, count_as_source) && read_array(cursor, end, count_as_target)
+        && read_array(cursor, end, target_offsets) && read_array(cursor, end, target_enums)
+        && cursor == end;
+    // the arrays should agree in size, and the edges be between the nodes
+    const int64_t nodes = node_count();
+    valid = valid && edge_targets.size() == edge_sources.size() && target_enums.size() == edge_sources.size()
+        && int64_t(count_as_source.size()) == nodes && int64_t(count_as_target.size()) == nodes
+        && int64_t(target_offsets.size()) == nodes + 1
+        && target_offsets.front() == 0 && target_offsets.back() == edge_count();
+    for (int64_t n = 0; valid && n < nodes; n++) {
+        valid = target_offsets[n] <= target_offsets[n + 1];
+    }
+    for (int64_t i = 0; valid && i < edge_count(); i++) {
+        valid = edge_sources[i] >= 0 && edge_sources[i] < nodes && edge_targets[i] >= 0 && edge_targets[i] < nodes
+            && target_enums[i] >= 0 && target_enums[i] < nodes;
+    }
+    if (!valid) {
+        *this = Digraph();
+    }
+    return valid;
 }
 
-Node& Digraph::find_or_create_node(const std::string& node_name) {
-    try {
-        return *(name2node.at(node_name));
-    } catch (const std::out_of_range) {
-        Node* node_ptr = new Node(node_name, enumeration2node.size());
-        name2node[node_name] = node_ptr;
-        enumeration2node.push_back(node_ptr);
-        return *node_ptr;
+bool Digraph::write_cache(const std::string& cache_filename, int64_t source_size, int64_t source_mtime) const {
+    // write to a temporary file, so that no other run reads a partial copy
+    const std::string temporary = cache_filename + ".tmp" + std::to_string(getpid());
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    write_value(out, CACHE_VERSION);
+    write_value(out, uint32_t(sizeof(node_t)));
+    write_value(out, source_size);
+    write_value(out, source_mtime);
+    names.write(out);
+    write_array(out, edge_sources);
+    write_array(out, edge_targets);
+    write_array(out, count_as_source);
+    write_array(out, count_as_target);
+    write_array(out, target_offsets);
+    write_array(out, target_enums);
+    out.close();
+    if (!out || rename(temporary.c_str(), cache_filename.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
     }
+    return true;
 }
 
 }
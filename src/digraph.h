@@ -1,36 +1,38 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <istream>
-#include <unordered_map>
+#include "names.h"
+#include "node.h"
 
 namespace poincare {
 
-struct Node {
-    Node(std::string name_, int32_t enumeration_) : count_as_source(0), count_as_target(0), target_enums(), name(name_), enumeration(enumeration_) {}
-    const std::string name;
-    const int32_t enumeration;
-    int64_t count_as_source;
-    int64_t count_as_target;
-    std::vector<int32_t> target_enums;
-};
-
-struct Edge {
-    Node& source;
-    Node& target;
-    Edge(Node& source_, Node& target_) : source(source_), target(target_) {
-        source.count_as_source++;
-        target.count_as_target++;
-        source.target_enums.push_back(target.enumeration);
-    }
-};
-
 class Digraph {
+    /**
+     * A directed graph, held in flat arrays: the nodes are enumerated
+     * 0, ..., node_count() - 1 and the edges 0, ..., edge_count() - 1.
+     */
+
     public:
-        std::vector<Node*> enumeration2node;
-        std::unordered_map<std::string, Node*> name2node;
-        std::vector<Edge*> edges;
+        // the name of each node, numbered by the enumeration of the nodes
+        NameTable names;
+        // the source and target of each edge
+        std::vector<node_t> edge_sources;
+        std::vector<node_t> edge_targets;
+        // the number of edges from and to each node
+        std::vector<int64_t> count_as_source;
+        std::vector<int64_t> count_as_target;
+        // the targets of the edges from node n (in the order of the edges,
+        // with any repeats) are target_enums[target_offsets[n]], ...,
+        // target_enums[target_offsets[n + 1] - 1]
+        std::vector<int64_t> target_offsets;
+        std::vector<node_t> target_enums;
+        // if the nodes have been relabelled, file_order[i] is the node that
+        // was i-th to appear in the CSV (otherwise this is empty, and it is
+        // node i)
+        std::vector<node_t> file_order;
 
         /**
          * Given an input stream giving the edges of a graph in tab-separated
@@ -42,25 +44,67 @@ class Digraph {
          * read this data, creating a Digraph object.
          * Raises a runtime_error if does not conform to format.
          * Post:
-         * + For each node X in referenced in the CSV, name2node[X] is a node
-         * object `node` such that node.name == X and `node` reflects the
-         * transitions and occurrence stats of that node in the file.
-         * + The lines of the CSV correspond in order to `edges`.
-         * + enumeration2node.size() == node_count() == number of distinct nodes in CSV
-         * + enumeration2node[n].enumeration == n for all 0 <= n < node_count()
+         * + The nodes are enumerated in order of first appearance in the CSV,
+         * names.name(n) is the name of node n, and names.find(names.name(n)) == n.
+         * + The lines of the CSV correspond in order to the edges.
+         * + node_count() == number of distinct nodes in CSV
          */
         Digraph(std::istream& in);
-        ~Digraph();
-        int64_t const node_count();
+
+        /**
+         * As above, reading the file with the given name, which is mapped
+         * into memory and parsed by up to `threads` threads (each taking a
+         * chunk of whole lines); the result is the same as for one thread.
+         * Raises an invalid_argument if the file cannot be opened.
+         */
+        Digraph(const std::string& filename, int32_t threads);
+
+        /**
+         * As above, but keeping a binary copy of the parsed graph in the file
+         * `cache_filename`.    If this was written by this version of the
+         * format (and size of node_t) from the graph file as it is now (judged by its size and
+         * modification time), the graph is read from it instead of parsing
+         * the graph file; otherwise the graph file is parsed and the copy
+         * (re)written.    Failing to write the copy is reported, not raised.
+         */
+        Digraph(const std::string& filename, int32_t threads, const std::string& cache_filename);
+
+        /**
+         * Renumber the nodes, so that node order[k] becomes node k, for a
+         * permutation `order` of the nodes.    The edges keep their order.
+         */
+        void relabel(const std::vector<node_t>& order);
+
+        int64_t node_count() const { return names.size(); }
+        int64_t edge_count() const { return edge_sources.size(); }
 
     protected:
+        Digraph() = default;
+
+        /**
+         * Parse the `size` characters from `data` (see the constructors),
+         * with up to `threads` threads.
+         */
+        void parse(const char* data, int64_t size, int32_t threads);
+
+        /**
+         * Compute the counts and the targets of each node from the edges.
+         */
+        void build_adjacency();
+
         /**
-         * Return a reference to the Node with that name,
-         * creating a new Node if necessary, updating
-         * enumeration2node and name2node
+         * Read the graph from the cache file, if this exists, is well-formed
+         * and was written from a graph file with the given size and
+         * modification time (in nanoseconds since the epoch); return whether
+         * it was.
          */
-        Node& find_or_create_node(const std::string& node_name);
+        bool read_cache(const std::string& cache_filename, int64_t source_size, int64_t source_mtime);
 
+        /**
+         * Write the graph to the cache file (via a temporary file, renamed
+         * into place once complete); return whether this succeeded.
+         */
+        bool write_cache(const std::string& cache_filename, int64_t source_size, int64_t source_mtime) const;
 };
 
 /**
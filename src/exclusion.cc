@@ -0,0 +1,62 @@
+#include "exclusion.h"
+
+#include <algorithm>
+
+namespace poincare {
+
+// the size of the bit filters, relative to the number of targets
+constexpr int64_t FILTER_BITS_PER_TARGET = 16;
+
+void RejectionStats::add(const RejectionStats& other) {
+    samples += other.samples;
+    rejections += other.rejections;
+    max_rejections = std::max(max_rejections, other.max_rejections);
+    lock_failures += other.lock_failures;
+    shortfalls += other.shortfalls;
+    missing += other.missing;
+}
+
+ExclusionIndex::ExclusionIndex(const Digraph& digraph, int64_t filter_degree) : filtered_nodes_(0) {
+    const int64_t nodes = digraph.node_count();
+    offsets_.assign(nodes + 1, 0);
+    filter_offsets_.assign(nodes, 0);
+    filter_shifts_.assign(nodes, 0);
+    for (int64_t n = 0; n < nodes; n++) {
+        int64_t begin = targets_.size();
+        targets_.insert(targets_.end(), digraph.target_enums.begin() + digraph.target_offsets[n],
+                        digraph.target_enums.begin() + digraph.target_offsets[n + 1]);
+        std::sort(targets_.begin() + begin, targets_.end());
+        targets_.erase(std::unique(targets_.begin() + begin, targets_.end()), targets_.end());
+        offsets_[n + 1] = targets_.size();
+        const int64_t degree = offsets_[n + 1] - begin;
+        if (degree < filter_degree || degree == 0) {
+            continue;
+        }
+        // a power of two number of bits (at least one word), indexed by the
+        // top bits of the hash
+        int32_t log2_bits = 6;
+        while ((int64_t(1) << log2_bits) < FILTER_BITS_PER_TARGET * degree && log2_bits < 31) {
+            log2_bits++;
+        }
+        filter_shifts_[n] = 32 - log2_bits;
+        filter_offsets_[n] = filter_words_.size();
+        filter_words_.resize(filter_words_.size() + (int64_t(1) << (log2_bits - 6)), 0);
+        for (int64_t i = begin; i < offsets_[n + 1]; i++) {
+            uint64_t bit = hash(targets_[i]) >> filter_shifts_[n];
+            filter_words_[filter_offsets_[n] + (bit >> 6)] |= uint64_t(1) << (bit & 63);
+        }
+        filtered_nodes_++;
+    }
+}
+
+bool ExclusionIndex::search(int64_t begin, int64_t end, node_t node) const {
+    return std::binary_search(targets_.begin() + begin, targets_.begin() + end, node);
+}
+
+int64_t ExclusionIndex::bytes() const {
+    return offsets_.size() * sizeof(int64_t) + targets_.size() * sizeof(node_t)
+        + filter_offsets_.size() * sizeof(int64_t) + filter_shifts_.size() * sizeof(uint8_t)
+        + filter_words_.size() * sizeof(uint64_t);
+}
+
+}
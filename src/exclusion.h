@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "digraph.h"
+
+namespace poincare {
+
+/**
+ * Counts of the negative samples drawn by a thread, of the draws rejected
+ * because they were excluded (i.e. targets of the source), and of how the
+ * acquisition of the negatives for an edge fell short.
+ */
+struct RejectionStats {
+    RejectionStats() : samples(0), rejections(0), max_rejections(0), lock_failures(0), shortfalls(0), missing(0) {}
+
+    void add(const RejectionStats& other);
+
+    int64_t samples;
+    int64_t rejections;
+    // the most rejections before any one sample was accepted
+    int64_t max_rejections;
+    // samples discarded because their lock was held by another thread
+    int64_t lock_failures;
+    // edges trained with fewer negatives than required, since the draws
+    // allowed ran out, and the number of negatives missing in total
+    int64_t shortfalls;
+    int64_t missing;
+};
+
+class ExclusionIndex {
+    /**
+     * For each node, the set of its targets, which are excluded as its
+     * negative samples.    The targets of all nodes are stored sorted, in one
+     * array (compressed sparse rows), and looked up by binary search.    Nodes
+     * with at least `filter_degree` targets also get a hashed bit filter (with
+     * about FILTER_BITS_PER_TARGET bits per target), so that most nodes that
+     * are not targets are rejected without searching.
+     */
+
+    public:
+        ExclusionIndex(const Digraph& digraph, int64_t filter_degree);
+
+        /**
+         * Return whether `node` is a target of `source`.
+         */
+        bool excludes(node_t source, node_t node) const {
+            const int64_t begin = offsets_[source];
+            const int64_t end = offsets_[source + 1];
+            if (begin == end) {
+                return false;
+            }
+            const int32_t shift = filter_shifts_[source];
+            if (shift > 0) {
+                uint64_t bit = hash(node) >> shift;
+                if (!(filter_words_[filter_offsets_[source] + (bit >> 6)] & (uint64_t(1) << (bit & 63)))) {
+                    return false;
+                }
+            }
+            return search(begin, end, node);
+        }
+
+        int64_t filtered_nodes() const { return filtered_nodes_; }
+
+        /**
+         * Return the number of bytes used by the index.
+         */
+        int64_t bytes() const;
+
+    protected:
+        static uint32_t hash(node_t node) { return uint32_t(uint64_t(node) ^ (uint64_t(node) >> 32)) * 2654435769u; }
+
+        bool search(int64_t begin, int64_t end, node_t node) const;
+
+        // the targets of node n are targets_[offsets_[n]], ..., targets_[offsets_[n + 1] - 1]
+        std::vector<int64_t> offsets_;
+        std::vector<node_t> targets_;
+        // the filter of node n (if filter_shifts_[n] > 0) has 2^(32 - filter_shifts_[n])
+        // bits, from filter_words_[filter_offsets_[n]] on
+        std::vector<int64_t> filter_offsets_;
+        std::vector<uint8_t> filter_shifts_;
+        std::vector<uint64_t> filter_words_;
+        int64_t filtered_nodes_;
+};
+
+}
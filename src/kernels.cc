@@ -0,0 +1,166 @@
+#include "kernels.h"
+
+namespace poincare {
+
+template <typename T>
+T scalar_dot(const T* x, const T* y, int64_t n) {
+    T result = 0;
+    for (int64_t i = 0; i < n; i++) {
+        result += x[i] * y[i];
+    }
+    return result;
+}
+
+template <typename T>
+T scalar_minkowski_dot(const T* x, const T* y, int64_t n) {
+    return scalar_dot(x, y, n - 1) - x[n - 1] * y[n - 1];
+}
+
+template <typename T>
+T scalar_squared_dist(const T* x, const T* y, int64_t n) {
+    T result = 0;
+    for (int64_t i = 0; i < n; i++) {
+        T diff = x[i] - y[i];
+        result += diff * diff;
+    }
+    return result;
+}
+
+template <typename T>
+void scalar_scale(T* x, T a, int64_t n) {
+    for (int64_t i = 0; i < n; i++) {
+        x[i] *= a;
+    }
+}
+
+template <typename T>
+void scalar_axpy(T* y, T a, const T* x, int64_t n) {
+    for (int64_t i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+template <typename T>
+T scalar_axpby(T* y, T a, T b, const T* x, int64_t n) {
+    T result = 0;
+    for (int64_t i = 0; i < n; i++) {
+        y[i] = a * y[i] + b * x[i];
+        result += y[i] * y[i];
+    }
+    return result;
+}
+
+template <typename T>
+T scalar_accumulate_axpby(T* z, T c, T* y, T a, T b, const T* x, int64_t n) {
+    T result = 0;
+    for (int64_t i = 0; i < n; i++) {
+        z[i] += c * y[i];
+        y[i] = a * y[i] + b * x[i];
+        result += y[i] * y[i];
+    }
+    return result;
+}
+
+template <typename T>
+void scalar_minkowski_gemm(T* c, const T* a, int64_t rows, const T* b, int64_t m, int64_t n) {
+    for (int64_t i = 0; i < rows; i++) {
+        const T* a_i = a + i * n;
+        T* c_i = c + i * m;
+        // accumulate the products a row of b at a time
+        for (int64_t j = 0; j < m; j++) {
+            c_i[j] = -a_i[n - 1] * b[(n - 1) * m + j];
+        }
+        for (int64_t k = 0; k < n - 1; k++) {
+            scalar_axpy(c_i, a_i[k], b + k * m, m);
+        }
+    }
+}
+
+template <typename T>
+const Kernels<T>* scalar_kernels() {
+    static const Kernels<T> table = {
+        Isa::SCALAR,
+        scalar_dot<T>,
+        scalar_minkowski_dot<T>,
+        scalar_squared_dist<T>,
+        scalar_scale<T>,
+        scalar_axpy<T>,
+        scalar_axpby<T>,
+        scalar_accumulate_axpby<T>,
+        scalar_minkowski_gemm<T>
+    };
+    return &table;
+}
+
+// no vector implementations for long double (the x87 unit is scalar)
+template <typename T>
+const Kernels<T>* avx2_kernels() {
+    return nullptr;
+}
+
+template <typename T>
+const Kernels<T>* avx512_kernels() {
+    return nullptr;
+}
+
+bool isa_supported(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return true;
+    }
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2:
+            return "avx2";
+        case Isa::AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+template <typename T>
+const Kernels<T>* kernels_for(Isa isa) {
+    if (!isa_supported(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+        case Isa::AVX2:
+            return avx2_kernels<T>();
+        case Isa::AVX512:
+            return avx512_kernels<T>();
+        default:
+            return scalar_kernels<T>();
+    }
+}
+
+template <typename T>
+const Kernels<T>& kernels() {
+    static const Kernels<T>* best = []() {
+        const Isa preference[] = {Isa::AVX512, Isa::AVX2};
+        for (Isa isa : preference) {
+            const Kernels<T>* candidate = kernels_for<T>(isa);
+            if (candidate != nullptr) {
+                return candidate;
+            }
+        }
+        return scalar_kernels<T>();
+    }();
+    return *best;
+}
+
+template const Kernels<float>* kernels_for<float>(Isa);
+template const Kernels<double>* kernels_for<double>(Isa);
+template const Kernels<long double>* kernels_for<long double>(Isa);
+
+template const Kernels<float>& kernels<float>();
+template const Kernels<double>& kernels<double>();
+template const Kernels<long double>& kernels<long double>();
+
+}
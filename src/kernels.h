@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+namespace poincare {
+
+/**
+ * Instruction sets for which vector kernels are implemented.
+ */
+enum class Isa {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+template <typename T>
+struct Kernels {
+    /**
+     * The loops over co-ordinates that make up almost all of the arithmetic
+     * of training, each implemented for a particular instruction set.    All
+     * take the number of entries `n`; none require alignment.
+     */
+
+    Isa isa;
+
+    // Return the inner product of x and y.
+    T (*dot)(const T* x, const T* y, int64_t n);
+
+    // Return the Minkowski inner product of x and y, where the last
+    // co-ordinate is time-like.
+    T (*minkowski_dot)(const T* x, const T* y, int64_t n);
+
+    // Return the squared Euclidean distance between x and y.
+    T (*squared_dist)(const T* x, const T* y, int64_t n);
+
+    // Multiply x by a, in place.
+    void (*scale)(T* x, T a, int64_t n);
+
+    // Add a * x to y, in place.
+    void (*axpy)(T* y, T a, const T* x, int64_t n);
+
+    // Replace y with a * y + b * x, returning the squared norm of the result.
+    T (*axpby)(T* y, T a, T b, const T* x, int64_t n);
+
+    // Add c * y to z, then replace y with a * y + b * x, returning the
+    // squared norm of the result (in a single pass over y).
+    T (*accumulate_axpby)(T* z, T c, T* y, T a, T b, const T* x, int64_t n);
+
+    // Set c[i * m + j] to the Minkowski inner product of row i of the
+    // `rows` x n matrix a with column j of the n x m matrix b (both stored
+    // row by row, without padding), for all i and j: a blocked matrix
+    // product.
+    void (*minkowski_gemm)(T* c, const T* a, int64_t rows, const T* b, int64_t m, int64_t n);
+};
+
+/**
+ * Return whether the CPU we are running on supports the instruction set.
+ */
+bool isa_supported(Isa);
+
+/**
+ * Return the name of the instruction set, e.g. "avx2".
+ */
+const char* isa_name(Isa);
+
+/**
+ * Return the kernels for the specified instruction set, or nullptr if they
+ * are not implemented for T or not supported by this CPU.
+ */
+template <typename T>
+const Kernels<T>* kernels_for(Isa);
+
+/**
+ * Return the fastest kernels supported by this CPU (chosen on first call).
+ */
+template <typename T>
+const Kernels<T>& kernels();
+
+// The tables for each instruction set, regardless of CPU support (nullptr if
+// not implemented for T).
+template <typename T>
+const Kernels<T>* avx2_kernels();
+template <typename T>
+const Kernels<T>* avx512_kernels();
+
+template <> const Kernels<float>* avx2_kernels<float>();
+template <> const Kernels<double>* avx2_kernels<double>();
+template <> const Kernels<float>* avx512_kernels<float>();
+template <> const Kernels<double>* avx512_kernels<double>();
+
+}
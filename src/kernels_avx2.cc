@@ -0,0 +1,234 @@
+#include "kernels.h"
+
+#include <immintrin.h>
+
+// Compiled for all CPUs, but only ever called if isa_supported(Isa::AVX2).
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+namespace poincare {
+
+template <typename T>
+struct Avx2;
+
+template <>
+struct Avx2<float> {
+    typedef __m256 reg;
+    static const int64_t lanes = 8;
+    TARGET_AVX2 static reg zero() { return _mm256_setzero_ps(); }
+    TARGET_AVX2 static reg set1(float a) { return _mm256_set1_ps(a); }
+    TARGET_AVX2 static reg load(const float* p) { return _mm256_loadu_ps(p); }
+    TARGET_AVX2 static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+    TARGET_AVX2 static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    TARGET_AVX2 static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    TARGET_AVX2 static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    TARGET_AVX2 static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    TARGET_AVX2 static float sum(reg v) {
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+        return _mm_cvtss_f32(lo);
+    }
+};
+
+template <>
+struct Avx2<double> {
+    typedef __m256d reg;
+    static const int64_t lanes = 4;
+    TARGET_AVX2 static reg zero() { return _mm256_setzero_pd(); }
+    TARGET_AVX2 static reg set1(double a) { return _mm256_set1_pd(a); }
+    TARGET_AVX2 static reg load(const double* p) { return _mm256_loadu_pd(p); }
+    TARGET_AVX2 static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+    TARGET_AVX2 static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    TARGET_AVX2 static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    TARGET_AVX2 static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    TARGET_AVX2 static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    TARGET_AVX2 static double sum(reg v) {
+        __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        lo = _mm_add_sd(lo, _mm_unpackhi_pd(lo, lo));
+        return _mm_cvtsd_f64(lo);
+    }
+};
+
+template <typename T>
+TARGET_AVX2 T avx2_dot(const T* x, const T* y, int64_t n) {
+    typedef Avx2<T> V;
+    typename V::reg acc0 = V::zero();
+    typename V::reg acc1 = V::zero();
+    int64_t i = 0;
+    for (; i + 2 * V::lanes <= n; i += 2 * V::lanes) {
+        acc0 = V::fmadd(V::load(x + i), V::load(y + i), acc0);
+        acc1 = V::fmadd(V::load(x + i + V::lanes), V::load(y + i + V::lanes), acc1);
+    }
+    for (; i + V::lanes <= n; i += V::lanes) {
+        acc0 = V::fmadd(V::load(x + i), V::load(y + i), acc0);
+    }
+    T result = V::sum(V::add(acc0, acc1));
+    for (; i < n; i++) {
+        result += x[i] * y[i];
+    }
+    return result;
+}
+
+template <typename T>
+TARGET_AVX2 T avx2_minkowski_dot(const T* x, const T* y, int64_t n) {
+    return avx2_dot(x, y, n - 1) - x[n - 1] * y[n - 1];
+}
+
+template <typename T>
+TARGET_AVX2 T avx2_squared_dist(const T* x, const T* y, int64_t n) {
+    typedef Avx2<T> V;
+    typename V::reg acc = V::zero();
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        typename V::reg diff = V::sub(V::load(x + i), V::load(y + i));
+        acc = V::fmadd(diff, diff, acc);
+    }
+    T result = V::sum(acc);
+    for (; i < n; i++) {
+        T diff = x[i] - y[i];
+        result += diff * diff;
+    }
+    return result;
+}
+
+template <typename T>
+TARGET_AVX2 void avx2_scale(T* x, T a, int64_t n) {
+    typedef Avx2<T> V;
+    typename V::reg factor = V::set1(a);
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        V::store(x + i, V::mul(V::load(x + i), factor));
+    }
+    for (; i < n; i++) {
+        x[i] *= a;
+    }
+}
+
+template <typename T>
+TARGET_AVX2 void avx2_axpy(T* y, T a, const T* x, int64_t n) {
+    typedef Avx2<T> V;
+    typename V::reg factor = V::set1(a);
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        V::store(y + i, V::fmadd(factor, V::load(x + i), V::load(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+template <typename T>
+TARGET_AVX2 T avx2_axpby(T* y, T a, T b, const T* x, int64_t n) {
+    typedef Avx2<T> V;
+    typename V::reg a_ = V::set1(a);
+    typename V::reg b_ = V::set1(b);
+    typename V::reg acc = V::zero();
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        typename V::reg result = V::fmadd(a_, V::load(y + i), V::mul(b_, V::load(x + i)));
+        V::store(y + i, result);
+        acc = V::fmadd(result, result, acc);
+    }
+    T squared_norm = V::sum(acc);
+    for (; i < n; i++) {
+        y[i] = a * y[i] + b * x[i];
+        squared_norm += y[i] * y[i];
+    }
+    return squared_norm;
+}
+
+template <typename T>
+TARGET_AVX2 T avx2_accumulate_axpby(T* z, T c, T* y, T a, T b, const T* x, int64_t n) {
+    typedef Avx2<T> V;
+    typename V::reg a_ = V::set1(a);
+    typename V::reg b_ = V::set1(b);
+    typename V::reg c_ = V::set1(c);
+    typename V::reg acc = V::zero();
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        typename V::reg y_i = V::load(y + i);
+        V::store(z + i, V::fmadd(c_, y_i, V::load(z + i)));
+        typename V::reg result = V::fmadd(a_, y_i, V::mul(b_, V::load(x + i)));
+        V::store(y + i, result);
+        acc = V::fmadd(result, result, acc);
+    }
+    T squared_norm = V::sum(acc);
+    for (; i < n; i++) {
+        z[i] += c * y[i];
+        y[i] = a * y[i] + b * x[i];
+        squared_norm += y[i] * y[i];
+    }
+    return squared_norm;
+}
+
+// The product of R rows of a with all the columns of b, for
+// avx2_minkowski_gemm, holding R registers of c at a time.
+template <typename T, int R>
+TARGET_AVX2 void avx2_gemm_rows(T* c, const T* a, const T* b, int64_t m, int64_t n) {
+    typedef Avx2<T> V;
+    int64_t j = 0;
+    for (; j + V::lanes <= m; j += V::lanes) {
+        typename V::reg acc[R];
+        typename V::reg time = V::load(b + (n - 1) * m + j);
+        for (int r = 0; r < R; r++) {
+            acc[r] = V::mul(V::set1(-a[r * n + n - 1]), time);
+        }
+        for (int64_t k = 0; k < n - 1; k++) {
+            typename V::reg b_k = V::load(b + k * m + j);
+            for (int r = 0; r < R; r++) {
+                acc[r] = V::fmadd(V::set1(a[r * n + k]), b_k, acc[r]);
+            }
+        }
+        for (int r = 0; r < R; r++) {
+            V::store(c + r * m + j, acc[r]);
+        }
+    }
+    for (; j < m; j++) {
+        for (int r = 0; r < R; r++) {
+            T result = -a[r * n + n - 1] * b[(n - 1) * m + j];
+            for (int64_t k = 0; k < n - 1; k++) {
+                result += a[r * n + k] * b[k * m + j];
+            }
+            c[r * m + j] = result;
+        }
+    }
+}
+
+template <typename T>
+TARGET_AVX2 void avx2_minkowski_gemm(T* c, const T* a, int64_t rows, const T* b, int64_t m, int64_t n) {
+    int64_t i = 0;
+    for (; i + 4 <= rows; i += 4) {
+        avx2_gemm_rows<T, 4>(c + i * m, a + i * n, b, m, n);
+    }
+    for (; i < rows; i++) {
+        avx2_gemm_rows<T, 1>(c + i * m, a + i * n, b, m, n);
+    }
+}
+
+template <typename T>
+const Kernels<T>* avx2_table() {
+    static const Kernels<T> table = {
+        Isa::AVX2,
+        avx2_dot<T>,
+        avx2_minkowski_dot<T>,
+        avx2_squared_dist<T>,
+        avx2_scale<T>,
+        avx2_axpy<T>,
+        avx2_axpby<T>,
+        avx2_accumulate_axpby<T>,
+        avx2_minkowski_gemm<T>
+    };
+    return &table;
+}
+
+template <>
+const Kernels<float>* avx2_kernels<float>() {
+    return avx2_table<float>();
+}
+
+template <>
+const Kernels<double>* avx2_kernels<double>() {
+    return avx2_table<double>();
+}
+
+}
@@ -0,0 +1,243 @@
+#include "kernels.h"
+
+#include <algorithm>
+#include <immintrin.h>
+
+// Compiled for all CPUs, but only ever called if isa_supported(Isa::AVX512).
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+namespace poincare {
+
+template <typename T>
+struct Avx512;
+
+template <>
+struct Avx512<float> {
+    typedef __m512 reg;
+    typedef __mmask16 mask;
+    static const int64_t lanes = 16;
+    // mask selecting the first `count` (<= lanes) entries
+    TARGET_AVX512 static mask first(int64_t count) { return (mask) ((1u << count) - 1); }
+    TARGET_AVX512 static reg zero() { return _mm512_setzero_ps(); }
+    TARGET_AVX512 static reg set1(float a) { return _mm512_set1_ps(a); }
+    TARGET_AVX512 static reg load(const float* p) { return _mm512_loadu_ps(p); }
+    TARGET_AVX512 static reg load(const float* p, mask m) { return _mm512_maskz_loadu_ps(m, p); }
+    TARGET_AVX512 static void store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+    TARGET_AVX512 static void store(float* p, reg v, mask m) { _mm512_mask_storeu_ps(p, m, v); }
+    TARGET_AVX512 static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    TARGET_AVX512 static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    TARGET_AVX512 static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    TARGET_AVX512 static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    // GCC 12 warns that the reduction reads an uninitialised register (the
+    // _mm512_undefined_ps() the intrinsic passes for unused lanes)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+    TARGET_AVX512 static float sum(reg v) { return _mm512_reduce_add_ps(v); }
+#pragma GCC diagnostic pop
+};
+
+template <>
+struct Avx512<double> {
+    typedef __m512d reg;
+    typedef __mmask8 mask;
+    static const int64_t lanes = 8;
+    TARGET_AVX512 static mask first(int64_t count) { return (mask) ((1u << count) - 1); }
+    TARGET_AVX512 static reg zero() { return _mm512_setzero_pd(); }
+    TARGET_AVX512 static reg set1(double a) { return _mm512_set1_pd(a); }
+    TARGET_AVX512 static reg load(const double* p) { return _mm512_loadu_pd(p); }
+    TARGET_AVX512 static reg load(const double* p, mask m) { return _mm512_maskz_loadu_pd(m, p); }
+    TARGET_AVX512 static void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+    TARGET_AVX512 static void store(double* p, reg v, mask m) { _mm512_mask_storeu_pd(p, m, v); }
+    TARGET_AVX512 static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    TARGET_AVX512 static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    TARGET_AVX512 static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    TARGET_AVX512 static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+    TARGET_AVX512 static double sum(reg v) { return _mm512_reduce_add_pd(v); }
+#pragma GCC diagnostic pop
+};
+
+// The remainder of each loop (fewer than `lanes` entries) is handled with
+// masked loads and stores, whose masked-out lanes are zero.
+
+template <typename T>
+TARGET_AVX512 T avx512_dot(const T* x, const T* y, int64_t n) {
+    typedef Avx512<T> V;
+    typename V::reg acc0 = V::zero();
+    typename V::reg acc1 = V::zero();
+    int64_t i = 0;
+    for (; i + 2 * V::lanes <= n; i += 2 * V::lanes) {
+        acc0 = V::fmadd(V::load(x + i), V::load(y + i), acc0);
+        acc1 = V::fmadd(V::load(x + i + V::lanes), V::load(y + i + V::lanes), acc1);
+    }
+    for (; i + V::lanes <= n; i += V::lanes) {
+        acc0 = V::fmadd(V::load(x + i), V::load(y + i), acc0);
+    }
+    if (i < n) {
+        typename V::mask m = V::first(n - i);
+        acc1 = V::fmadd(V::load(x + i, m), V::load(y + i, m), acc1);
+    }
+    return V::sum(V::add(acc0, acc1));
+}
+
+template <typename T>
+TARGET_AVX512 T avx512_minkowski_dot(const T* x, const T* y, int64_t n) {
+    return avx512_dot(x, y, n - 1) - x[n - 1] * y[n - 1];
+}
+
+template <typename T>
+TARGET_AVX512 T avx512_squared_dist(const T* x, const T* y, int64_t n) {
+    typedef Avx512<T> V;
+    typename V::reg acc = V::zero();
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        typename V::reg diff = V::sub(V::load(x + i), V::load(y + i));
+        acc = V::fmadd(diff, diff, acc);
+    }
+    if (i < n) {
+        typename V::mask m = V::first(n - i);
+        typename V::reg diff = V::sub(V::load(x + i, m), V::load(y + i, m));
+        acc = V::fmadd(diff, diff, acc);
+    }
+    return V::sum(acc);
+}
+
+template <typename T>
+TARGET_AVX512 void avx512_scale(T* x, T a, int64_t n) {
+    typedef Avx512<T> V;
+    typename V::reg factor = V::set1(a);
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        V::store(x + i, V::mul(V::load(x + i), factor));
+    }
+    if (i < n) {
+        typename V::mask m = V::first(n - i);
+        V::store(x + i, V::mul(V::load(x + i, m), factor), m);
+    }
+}
+
+template <typename T>
+TARGET_AVX512 void avx512_axpy(T* y, T a, const T* x, int64_t n) {
+    typedef Avx512<T> V;
+    typename V::reg factor = V::set1(a);
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        V::store(y + i, V::fmadd(factor, V::load(x + i), V::load(y + i)));
+    }
+    if (i < n) {
+        typename V::mask m = V::first(n - i);
+        V::store(y + i, V::fmadd(factor, V::load(x + i, m), V::load(y + i, m)), m);
+    }
+}
+
+template <typename T>
+TARGET_AVX512 T avx512_axpby(T* y, T a, T b, const T* x, int64_t n) {
+    typedef Avx512<T> V;
+    typename V::reg a_ = V::set1(a);
+    typename V::reg b_ = V::set1(b);
+    typename V::reg acc = V::zero();
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        typename V::reg result = V::fmadd(a_, V::load(y + i), V::mul(b_, V::load(x + i)));
+        V::store(y + i, result);
+        acc = V::fmadd(result, result, acc);
+    }
+    if (i < n) {
+        typename V::mask m = V::first(n - i);
+        typename V::reg result = V::fmadd(a_, V::load(y + i, m), V::mul(b_, V::load(x + i, m)));
+        V::store(y + i, result, m);
+        acc = V::fmadd(result, result, acc);
+    }
+    return V::sum(acc);
+}
+
+template <typename T>
+TARGET_AVX512 T avx512_accumulate_axpby(T* z, T c, T* y, T a, T b, const T* x, int64_t n) {
+    typedef Avx512<T> V;
+    typename V::reg a_ = V::set1(a);
+    typename V::reg b_ = V::set1(b);
+    typename V::reg c_ = V::set1(c);
+    typename V::reg acc = V::zero();
+    int64_t i = 0;
+    for (; i + V::lanes <= n; i += V::lanes) {
+        typename V::reg y_i = V::load(y + i);
+        V::store(z + i, V::fmadd(c_, y_i, V::load(z + i)));
+        typename V::reg result = V::fmadd(a_, y_i, V::mul(b_, V::load(x + i)));
+        V::store(y + i, result);
+        acc = V::fmadd(result, result, acc);
+    }
+    if (i < n) {
+        typename V::mask m = V::first(n - i);
+        typename V::reg y_i = V::load(y + i, m);
+        V::store(z + i, V::fmadd(c_, y_i, V::load(z + i, m)), m);
+        typename V::reg result = V::fmadd(a_, y_i, V::mul(b_, V::load(x + i, m)));
+        V::store(y + i, result, m);
+        acc = V::fmadd(result, result, acc);
+    }
+    return V::sum(acc);
+}
+
+// The product of R rows of a with all the columns of b, for
+// avx512_minkowski_gemm, holding R registers of c at a time (the last,
+// partial, block of columns masked).
+template <typename T, int R>
+TARGET_AVX512 void avx512_gemm_rows(T* c, const T* a, const T* b, int64_t m, int64_t n) {
+    typedef Avx512<T> V;
+    for (int64_t j = 0; j < m; j += V::lanes) {
+        typename V::mask cols = V::first(std::min<int64_t>(m - j, V::lanes));
+        typename V::reg acc[R];
+        typename V::reg time = V::load(b + (n - 1) * m + j, cols);
+        for (int r = 0; r < R; r++) {
+            acc[r] = V::mul(V::set1(-a[r * n + n - 1]), time);
+        }
+        for (int64_t k = 0; k < n - 1; k++) {
+            typename V::reg b_k = V::load(b + k * m + j, cols);
+            for (int r = 0; r < R; r++) {
+                acc[r] = V::fmadd(V::set1(a[r * n + k]), b_k, acc[r]);
+            }
+        }
+        for (int r = 0; r < R; r++) {
+            V::store(c + r * m + j, acc[r], cols);
+        }
+    }
+}
+
+template <typename T>
+TARGET_AVX512 void avx512_minkowski_gemm(T* c, const T* a, int64_t rows, const T* b, int64_t m, int64_t n) {
+    int64_t i = 0;
+    for (; i + 4 <= rows; i += 4) {
+        avx512_gemm_rows<T, 4>(c + i * m, a + i * n, b, m, n);
+    }
+    for (; i < rows; i++) {
+        avx512_gemm_rows<T, 1>(c + i * m, a + i * n, b, m, n);
+    }
+}
+
+template <typename T>
+const Kernels<T>* avx512_table() {
+    static const Kernels<T> table = {
+        Isa::AVX512,
+        avx512_dot<T>,
+        avx512_minkowski_dot<T>,
+        avx512_squared_dist<T>,
+        avx512_scale<T>,
+        avx512_axpy<T>,
+        avx512_axpby<T>,
+        avx512_accumulate_axpby<T>,
+        avx512_minkowski_gemm<T>
+    };
+    return &table;
+}
+
+template <>
+const Kernels<float>* avx512_kernels<float>() {
+    return avx512_table<float>();
+}
+
+template <>
+const Kernels<double>* avx512_kernels<double>() {
+    return avx512_table<double>();
+}
+
+}
@@ -0,0 +1,70 @@
+#include "locks.h"
+
+#include <stdexcept>
+
+namespace poincare {
+
+// the stripes are spaced this many bytes apart, so that no two share a cache line
+constexpr int64_t CACHE_LINE_SIZE = 64;
+
+LockTable::LockTable(int64_t nodes, LockTableMode mode, int64_t stripes) {
+    mode_ = mode;
+    spacing_ = 1;
+    switch (mode) {
+        case LockTableMode::BIT:
+            slots_ = nodes;
+            words_.reset(new std::atomic<uint64_t>[(nodes + 63) / 64]);
+            for (int64_t i = 0; i < (nodes + 63) / 64; i++) {
+                words_[i].store(0, std::memory_order_relaxed);
+            }
+            return;
+        case LockTableMode::STRIPED:
+            if (stripes <= 0) {
+                throw std::invalid_argument("the number of lock stripes must be positive");
+            }
+            slots_ = stripes;
+            spacing_ = CACHE_LINE_SIZE;
+            break;
+        default:
+            slots_ = nodes;
+    }
+    flags_.reset(new std::atomic<uint8_t>[slots_ * spacing_]);
+    for (int64_t i = 0; i < slots_; i++) {
+        flags_[i * spacing_].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool LockTable::try_lock(int64_t slot) {
+    if (mode_ == LockTableMode::BIT) {
+        std::atomic<uint64_t>& word = words_[slot / 64];
+        const uint64_t mask = uint64_t(1) << (slot % 64);
+        // test before test-and-set, so that a held lock costs no write
+        if (word.load(std::memory_order_relaxed) & mask) {
+            return false;
+        }
+        return !(word.fetch_or(mask, std::memory_order_acquire) & mask);
+    }
+    std::atomic<uint8_t>& flag = flags_[slot * spacing_];
+    if (flag.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return !flag.exchange(1, std::memory_order_acquire);
+}
+
+void LockTable::unlock(int64_t slot) {
+    if (mode_ == LockTableMode::BIT) {
+        const uint64_t mask = uint64_t(1) << (slot % 64);
+        words_[slot / 64].fetch_and(~mask, std::memory_order_release);
+        return;
+    }
+    flags_[slot * spacing_].store(0, std::memory_order_release);
+}
+
+int64_t LockTable::bytes() const {
+    if (mode_ == LockTableMode::BIT) {
+        return ((slots_ + 63) / 64) * sizeof(uint64_t);
+    }
+    return slots_ * spacing_;
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "args.h"
+
+namespace poincare {
+
+class LockTable {
+    /**
+     * One try-lock per node, for the locking scheme of Poincare::obtain_vectors,
+     * held as a single atomic flag (test-and-set) instead of a std::mutex:
+     *   - LockTableMode::BIT: one bit per node;
+     *   - LockTableMode::BYTE: one byte per node;
+     *   - LockTableMode::STRIPED: a fixed number of locks (stripes), each on
+     *     its own cache line, shared between the nodes (node i uses stripe
+     *     i % stripes).
+     * Nodes are locked via their slot, so that the caller can recognise two
+     * nodes sharing a stripe and lock it only once.    Locks are not
+     * re-entrant: try_lock fails on a slot already held, even by the caller.
+     */
+
+    public:
+        /**
+         * A table of locks for `nodes` nodes.    `stripes` is only used for
+         * LockTableMode::STRIPED.
+         */
+        LockTable(int64_t nodes, LockTableMode mode, int64_t stripes);
+
+        LockTable(const LockTable&) = delete;
+        LockTable& operator=(const LockTable&) = delete;
+
+        /**
+         * Return the slot holding the lock of the node.
+         */
+        int64_t slot(int64_t node) const {
+            return mode_ == LockTableMode::STRIPED ? node % slots_ : node;
+        }
+
+        /**
+         * Attempt to acquire the lock in the slot, returning whether this
+         * succeeded (never blocks).
+         */
+        bool try_lock(int64_t slot);
+
+        /**
+         * Release the lock in the slot, which must be held by the caller.
+         */
+        void unlock(int64_t slot);
+
+        /**
+         * Return the number of bytes used by the table.
+         */
+        int64_t bytes() const;
+
+    protected:
+        LockTableMode mode_;
+        int64_t slots_;
+        // BIT: 64 locks per word
+        std::unique_ptr<std::atomic<uint64_t>[]> words_;
+        // BYTE and STRIPED: lock i is flags_[i * spacing_]
+        std::unique_ptr<std::atomic<uint8_t>[]> flags_;
+        int64_t spacing_;
+};
+
+}
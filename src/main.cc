@@ -1,5 +1,6 @@
 #include <iostream>
 #include <fenv.h>
+#include <limits>
 
 #include "poincare.h"
 #include "args.h"
@@ -7,13 +8,34 @@
 
 using namespace poincare;
 
+template <typename T>
+void run(std::shared_ptr<Args> a) {
+    int excepts = FE_OVERFLOW | FE_DIVBYZERO | FE_INVALID;
+    if (std::numeric_limits<T>::min_exponent <= std::numeric_limits<long double>::min_exponent) {
+        // at lower precisions, the gradient weights of distant pairs of points
+        // can underflow; this is harmless, so only trap it for long double
+        excepts |= FE_UNDERFLOW;
+    }
+    feenableexcept(excepts);
+    Poincare<T> poincare(a);
+    poincare.train();
+    poincare.save_vectors(a->output_vectors);
+}
+
 int main(int argc, char** argv) {
-    feenableexcept(FE_OVERFLOW | FE_UNDERFLOW | FE_DIVBYZERO | FE_INVALID);
     std::vector<std::string> args(argv, argv + argc);
     std::shared_ptr<Args> a = std::make_shared<Args>();
     a->parse_args(args);
-    Poincare poincare(a);
-    poincare.train();
-    poincare.save_vectors(a->output_vectors);
+    switch (a->precision) {
+        case Precision::FLOAT:
+            run<float>(a);
+            break;
+        case Precision::DOUBLE:
+            run<double>(a);
+            break;
+        case Precision::LONG_DOUBLE:
+            run<long double>(a);
+            break;
+    }
     return 0;
 }
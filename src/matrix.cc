@@ -0,0 +1,84 @@
+#include "matrix.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <new>
+
+namespace poincare {
+
+// transparent huge pages are 2MB on x86-64
+constexpr int64_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+template <typename T>
+Matrix<T>::Matrix(int64_t rows, int64_t cols, bool huge_pages) {
+    rows_ = rows;
+    cols_ = cols;
+    const int64_t per_line = ROW_ALIGNMENT / sizeof(T);
+    stride_ = ((cols + per_line - 1) / per_line) * per_line;
+    bytes_ = rows_ * stride_ * sizeof(T);
+    mapped_ = false;
+    data_ = nullptr;
+    if (bytes_ == 0) {
+        return;
+    }
+    if (huge_pages) {
+        int64_t length = ((bytes_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+        void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED) {
+            // advisory only: if THP are disabled, we still have a (zeroed) mapping
+            madvise(ptr, length, MADV_HUGEPAGE);
+            bytes_ = length;
+            mapped_ = true;
+            data_ = static_cast<T*>(ptr);
+            return;
+        }
+    }
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, ROW_ALIGNMENT, bytes_) != 0) {
+        throw std::bad_alloc();
+    }
+    memset(ptr, 0, bytes_);
+    data_ = static_cast<T*>(ptr);
+}
+
+template <typename T>
+Matrix<T>::~Matrix() {
+    if (mapped_) {
+        munmap(data_, bytes_);
+    } else {
+        free(data_);
+    }
+}
+
+template <typename T>
+int64_t Matrix<T>::size() const {
+    return rows_;
+}
+
+template <typename T>
+int64_t Matrix<T>::cols() const {
+    return cols_;
+}
+
+template <typename T>
+int64_t Matrix<T>::stride() const {
+    return stride_;
+}
+
+template <typename T>
+T* Matrix<T>::row(int64_t i) {
+    return data_ + i * stride_;
+}
+
+template <typename T>
+const T* Matrix<T>::row(int64_t i) const {
+    return data_ + i * stride_;
+}
+
+template class Matrix<float>;
+template class Matrix<double>;
+template class Matrix<long double>;
+
+}
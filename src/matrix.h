@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+namespace poincare {
+
+// rows of the matrix are aligned to (and padded to a multiple of) this many bytes
+static const int64_t ROW_ALIGNMENT = 64;
+
+template <typename T>
+class Matrix {
+    /**
+     * A row-major matrix held in a single contiguous allocation, with each
+     * row aligned to ROW_ALIGNMENT bytes and padded with zeros up to the
+     * next multiple of that alignment.    Used to store the model parameters,
+     * one row per node, so that randomly gathered rows are cache-line
+     * aligned and share as few pages as possible.    `T` is the scalar type.
+     */
+
+    public:
+        /**
+         * Allocate a zeroed matrix with `rows` rows of `cols` entries.
+         * If `huge_pages`, then back the matrix with an anonymous mapping
+         * advised to use transparent huge pages (reducing TLB misses when
+         * sampling rows at random).
+         */
+        Matrix(int64_t rows, int64_t cols, bool huge_pages = false);
+        ~Matrix();
+
+        Matrix(const Matrix&) = delete;
+        Matrix& operator=(const Matrix&) = delete;
+
+        /**
+         * Return the number of rows.
+         */
+        int64_t size() const;
+
+        /**
+         * Return the number of (used) entries per row.
+         */
+        int64_t cols() const;
+
+        /**
+         * Return the distance, in entries, between the starts of consecutive rows.
+         */
+        int64_t stride() const;
+
+        /**
+         * Return a pointer to the first entry of the specified row.
+         */
+        T* row(int64_t);
+        const T* row(int64_t) const;
+
+    protected:
+        int64_t rows_;
+        int64_t cols_;
+        int64_t stride_;
+        int64_t bytes_;
+        bool mapped_;
+        T* data_;
+};
+
+}
@@ -1,97 +1,603 @@
 #include "model.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "kernels.h"
+
 namespace poincare {
 
-constexpr real MAX_MINKOWSKI_DOT = -1 - 1e-10;
-constexpr real MIN_STEP_SIZE = 1e-10;
+constexpr double MIN_STEP_SIZE = 1e-10;
+
+/**
+ * Return the largest value permitted for the Minkowski dot product of two
+ * (distinct) points; it must be far enough below -1 for (mdp^2 - 1) not to
+ * vanish at the precision T.
+ */
+template <typename T>
+inline T max_minkowski_dot() {
+    return -1 - std::max<T>(1e-10, 16 * std::numeric_limits<T>::epsilon());
+}
+
+/**
+ * Return the largest value permitted for the time-like co-ordinate of a point
+ * on the hyperboloid (i.e. the cosh of its distance from the basepoint).
+ * This ensures that the Minkowski dot products between points, and their
+ * squares, are representable at the precision T (it is only ever reached in
+ * practice for float, where it corresponds to a distance of about 21).
+ */
+template <typename T>
+inline T max_time_coordinate() {
+    return std::pow(std::numeric_limits<T>::max(), (T) 0.25) / 2;
+}
+
+/**
+ * Loops over the co-ordinates of rows whose length is only known at runtime,
+ * using the vector kernels.
+ */
+template <typename T>
+struct DynamicRows {
+    const int64_t n;
+    const Kernels<T>& k;
+
+    explicit DynamicRows(int64_t n_) : n(n_), k(kernels<T>()) {}
+    int64_t size() const { return n; }
+    T minkowski_dot(const T* x, const T* y) const { return k.minkowski_dot(x, y, n); }
+    T spatial_squared_norm(const T* x) const { return k.dot(x, x, n - 1); }
+    void scale(T* x, T a) const { k.scale(x, a, n); }
+    void axpy(T* y, T a, const T* x) const { k.axpy(y, a, x, n); }
+    void zero(T* x) const { std::fill(x, x + n, (T) 0); }
+    void copy(T* y, const T* x) const { std::copy(x, x + n, y); }
+    // as for the kernels of the same name, but over the space-like
+    // co-ordinates only
+    T spatial_axpby(T* y, T a, T b, const T* x) const { return k.axpby(y, a, b, x, n - 1); }
+    T spatial_accumulate_axpby(T* z, T c, T* y, T a, T b, const T* x) const {
+        return k.accumulate_axpby(z, c, y, a, b, x, n - 1);
+    }
+};
+
+// Rows longer than this are handled by the vector kernels even when their
+// length is known at compile time, since these outperform the unrolled loops
+constexpr int64_t MAX_UNROLLED_ROW = 32;
+
+/**
+ * Loops over the co-ordinates of rows of length N, known at compile time, so
+ * that the compiler can unroll them and keep small rows in registers.
+ */
+template <typename T, int64_t N>
+struct FixedRows : public DynamicRows<T> {
+    static const bool unrolled = N <= MAX_UNROLLED_ROW;
+
+    FixedRows() : DynamicRows<T>(N) {}
+    constexpr int64_t size() const { return N; }
+
+    T minkowski_dot(const T* x, const T* y) const {
+        if (!unrolled) {
+            return DynamicRows<T>::minkowski_dot(x, y);
+        }
+        T result = 0;
+        for (int64_t i = 0; i < N - 1; i++) {
+            result += x[i] * y[i];
+        }
+        return result - x[N - 1] * y[N - 1];
+    }
+
+    T spatial_squared_norm(const T* x) const {
+        if (!unrolled) {
+            return DynamicRows<T>::spatial_squared_norm(x);
+        }
+        T result = 0;
+        for (int64_t i = 0; i < N - 1; i++) {
+            result += x[i] * x[i];
+        }
+        return result;
+    }
+
+    void scale(T* x, T a) const {
+        if (!unrolled) {
+            return DynamicRows<T>::scale(x, a);
+        }
+        for (int64_t i = 0; i < N; i++) {
+            x[i] *= a;
+        }
+    }
+
+    void axpy(T* y, T a, const T* x) const {
+        if (!unrolled) {
+            return DynamicRows<T>::axpy(y, a, x);
+        }
+        for (int64_t i = 0; i < N; i++) {
+            y[i] += a * x[i];
+        }
+    }
+
+    void zero(T* x) const {
+        for (int64_t i = 0; i < N; i++) {
+            x[i] = 0;
+        }
+    }
 
-Model::Model(std::shared_ptr<std::vector<Vector>> vectors, std::shared_ptr<Args> args) {
+    void copy(T* y, const T* x) const {
+        for (int64_t i = 0; i < N; i++) {
+            y[i] = x[i];
+        }
+    }
+
+    T spatial_axpby(T* y, T a, T b, const T* x) const {
+        if (!unrolled) {
+            return DynamicRows<T>::spatial_axpby(y, a, b, x);
+        }
+        T result = 0;
+        for (int64_t i = 0; i < N - 1; i++) {
+            y[i] = a * y[i] + b * x[i];
+            result += y[i] * y[i];
+        }
+        return result;
+    }
+
+    T spatial_accumulate_axpby(T* z, T c, T* y, T a, T b, const T* x) const {
+        if (!unrolled) {
+            return DynamicRows<T>::spatial_accumulate_axpby(z, c, y, a, b, x);
+        }
+        T result = 0;
+        for (int64_t i = 0; i < N - 1; i++) {
+            z[i] += c * y[i];
+            y[i] = a * y[i] + b * x[i];
+            result += y[i] * y[i];
+        }
+        return result;
+    }
+};
+
+/**
+ * Copy the point on the Poincare ball `ball` (stored with a time-like
+ * co-ordinate of zero) to the corresponding hyperboloid point `point`.    The
+ * copy is pulled back inside the ball if necessary, since a read that raced a
+ * write of `ball` may have left it outside.
+ */
+template <typename T, class Rows>
+void load_ball_point(const Rows& rows, const T* ball, T* point) {
+    const int64_t n = rows.size();
+    rows.copy(point, ball);
+    T squared_norm = rows.spatial_squared_norm(point);
+    T factor = 1;
+    if (squared_norm >= BALL_MAX_DISTANCE * BALL_MAX_DISTANCE) {
+        factor = BALL_MAX_DISTANCE / std::sqrt(squared_norm);
+        squared_norm = BALL_MAX_DISTANCE * BALL_MAX_DISTANCE;
+    }
+    rows.scale(point, factor * 2 / (1 - squared_norm));
+    point[n - 1] = (1 + squared_norm) / (1 - squared_norm);
+}
+
+/**
+ * Write the hyperboloid point `point` to `ball` as a point on the Poincare ball
+ * (leaving the time-like co-ordinate of `ball`, which is zero, untouched).
+ */
+template <typename T, class Rows>
+void store_ball_point(const Rows& rows, const T* point, T* ball) {
+    const int64_t n = rows.size();
+    T factor = 1 / (point[n - 1] + 1);
+    for (int64_t i = 0; i < n - 1; i++) {
+        ball[i] = factor * point[i];
+    }
+}
+
+template <typename T>
+Model<T>::Model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args) {
     vectors_ = vectors;
     args_ = args;
     performance_ = 0.0;
     nexamples_ = 1;
     update_count = 1;
     pullback_count = 0;
+    mdps_.resize(args->number_negatives + 1);
+    activations_.resize(args->number_negatives + 1);
+    acc_source_gradient_.resize(vectors->cols());
+    sample_vecs_.resize(args->number_negatives + 1);
+    if (args->lock_free) {
+        local_vecs_.resize((args->number_negatives + 2) * vectors->cols());
+    }
+    group_source_ = -1;
+    group_vec_.resize(vectors->cols());
+    group_gradient_.resize(vectors->cols());
+}
+
+template <typename T>
+void Model<T>::update(Vector<T>& point, Vector<T>& tangent) {
+    DynamicRows<T> rows(point.size());
+    T tangent_norm = std::sqrt(std::max(rows.minkowski_dot(tangent.data_, tangent.data_), (T) 0));
+    step(rows, point.data_, 0, 1, tangent.data_, tangent_norm, nullptr, 0);
 }
 
-void Model::update(Vector& point, Vector& tangent) {
+template <typename T>
+template <class Rows>
+void Model<T>::step(const Rows& rows, T* point, T a, T b, const T* other, T tangent_norm,
+                    T* acc, T acc_weight) {
     update_count++;
-    real tangent_norm = std::sqrt(std::max(minkowski_dot(tangent, tangent), (real)0));
+    const int64_t n = rows.size();
     if (tangent_norm < MIN_STEP_SIZE) {
+        if (acc != nullptr) {
+            rows.axpy(acc, acc_weight, point);
+        }
         return;
     }
-    real step_size = tangent_norm;
-    // normalize the tangent vector
-    tangent.multiply(1.0 / tangent_norm);
     // clip the step size, if needed
-    if (step_size > args_->max_step_size) {
-        step_size = args_->max_step_size;
+    T step_size = std::min(tangent_norm, (T) args_->max_step_size);
+    // the new point (or, for the retraction, the new point on the ball) is
+    // point_coef * point + other_coef * other in its space-like co-ordinates
+    T point_coef;
+    T other_coef;
+    if (args_->additive_updates) {
+        // tangent, scaled to length step_size, mapped to the tangent space of
+        // the ball at the ball point point / (point[n - 1] + 1)
+        T scale = step_size / tangent_norm;
+        T denom = point[n - 1] + 1;
+        T tangent_time = scale * (a * point[n - 1] + b * other[n - 1]);
+        point_coef = (1 + scale * a - tangent_time / denom) / denom;
+        other_coef = scale * b / denom;
+    } else {
+        // geodesic updates
+        T sinh_step = std::sinh(step_size);
+        point_coef = std::cosh(step_size) + sinh_step * a / tangent_norm;
+        other_coef = sinh_step * b / tangent_norm;
+    }
+    T spatial_squared_norm;
+    if (acc != nullptr) {
+        acc[n - 1] += acc_weight * point[n - 1];
+        spatial_squared_norm = rows.spatial_accumulate_axpby(acc, acc_weight, point, point_coef, other_coef, other);
+    } else {
+        spatial_squared_norm = rows.spatial_axpby(point, point_coef, other_coef, other);
     }
     if (args_->additive_updates) {
-        tangent.multiply(step_size);
-        tangent.to_ball_tangent(point);
-        point.to_ball_point();
-        point.add(tangent);
-        // pull back inside the ball if necessary
-        real norm = std::sqrt(minkowski_dot(point, point));
-        if (norm >= 1) {
+        // pull back inside the ball if necessary (in the manner of Nickel &
+        // Kiela), then return to the hyperboloid
+        T factor = 1;
+        if (spatial_squared_norm >= 1) {
             pullback_count++;
-            point.multiply(BALL_MAX_DISTANCE / norm);
+            factor = BALL_MAX_DISTANCE / std::sqrt(spatial_squared_norm);
+            spatial_squared_norm = BALL_MAX_DISTANCE * BALL_MAX_DISTANCE;
         }
-        point.to_hyperboloid_point();
-        point.ensure_on_hyperboloid();
+        rows.scale(point, factor * 2 / (1 - spatial_squared_norm));
+        point[n - 1] = (1 + spatial_squared_norm) / (1 - spatial_squared_norm);
     } else {
-        // geodesic updates
-        point.geodesic_update(tangent, step_size);
+        point[n - 1] = std::sqrt(spatial_squared_norm + 1);
+    }
+    // pull back towards the basepoint if necessary
+    if (point[n - 1] > max_time_coordinate<T>()) {
+        pullback_count++;
+        T max_time = max_time_coordinate<T>();
+        T spatial_norm = std::sqrt(std::max(point[n - 1] * point[n - 1] - 1, (T) 0));
+        rows.scale(point, std::sqrt(max_time * max_time - 1) / spatial_norm);
+        point[n - 1] = max_time;
+    }
+}
+
+template <typename T>
+void Model<T>::nickel_kiela_objective(node_t source, std::vector<node_t>& samples, T lr) {
+    if (samples.size() > mdps_.size()) {
+        mdps_.resize(samples.size());
+        activations_.resize(samples.size());
+        sample_vecs_.resize(samples.size());
+    }
+    if (args_->lock_free && local_vecs_.size() < (samples.size() + 1) * vectors_->cols()) {
+        local_vecs_.resize((samples.size() + 1) * vectors_->cols());
     }
+    train_edge(DynamicRows<T>(vectors_->cols()), source, samples, lr, mdps_.data(), activations_.data(),
+               acc_source_gradient_.data(), sample_vecs_.data(), local_vecs_.data());
 }
 
-void Model::nickel_kiela_objective(int32_t source, std::vector<int32_t>& samples, real lr) {
-    Vector acc_source_gradient(args_->dimension + 1);
-    Vector sample_gradient(args_->dimension + 1);
+template <typename T>
+template <class Rows>
+void Model<T>::train_edge(const Rows& rows, node_t source, std::vector<node_t>& samples, T lr,
+                          T* mdps, T* activations, T* acc_source_gradient, T** sample_vecs, T* local_vecs) {
+    if (!args_->lock_free) {
+        train_samples(rows, vectors_->row(source), samples, lr, mdps, activations, acc_source_gradient,
+                      sample_vecs, local_vecs, nullptr);
+        return;
+    }
+    T* source_vec = local_vecs;
+    load_ball_point(rows, vectors_->row(source), source_vec);
+    train_samples(rows, source_vec, samples, lr, mdps, activations, acc_source_gradient,
+                  sample_vecs, local_vecs + rows.size(), nullptr);
+    store_ball_point(rows, source_vec, vectors_->row(source));
+}
+
+template <typename T>
+template <class Rows>
+void Model<T>::train_samples(const Rows& rows, T* source_vec, std::vector<node_t>& samples, T lr,
+                             T* mdps, T* activations, T* acc_source_gradient, T** sample_vecs, T* local_vecs,
+                             T* group_gradient) {
+    const int32_t count = samples.size();
+    if (!args_->lock_free) {
+        for (int32_t n = 0; n < count; n++) {
+            sample_vecs[n] = vectors_->row(samples[n]);
+        }
+        objective(rows, source_vec, sample_vecs, count, lr, mdps, activations, acc_source_gradient, group_gradient);
+        return;
+    }
+    for (int32_t n = 0; n < count; n++) {
+        sample_vecs[n] = local_vecs + n * rows.size();
+        load_ball_point(rows, vectors_->row(samples[n]), sample_vecs[n]);
+    }
+    objective(rows, source_vec, sample_vecs, count, lr, mdps, activations, acc_source_gradient, group_gradient);
+    for (int32_t n = 0; n < count; n++) {
+        store_ball_point(rows, sample_vecs[n], vectors_->row(samples[n]));
+    }
+}
+
+template <typename T>
+void Model<T>::begin_group(node_t source) {
+    DynamicRows<T> rows(vectors_->cols());
+    group_source_ = source;
+    if (args_->lock_free) {
+        load_ball_point(rows, vectors_->row(source), group_vec_.data());
+    } else {
+        rows.copy(group_vec_.data(), vectors_->row(source));
+    }
+    rows.zero(group_gradient_.data());
+}
+
+template <typename T>
+void Model<T>::group_edge(std::vector<node_t>& samples, T lr) {
+    if (samples.size() > mdps_.size()) {
+        mdps_.resize(samples.size());
+        activations_.resize(samples.size());
+        sample_vecs_.resize(samples.size());
+    }
+    if (args_->lock_free && local_vecs_.size() < samples.size() * vectors_->cols()) {
+        local_vecs_.resize(samples.size() * vectors_->cols());
+    }
+    train_samples(DynamicRows<T>(vectors_->cols()), group_vec_.data(), samples, lr, mdps_.data(),
+                  activations_.data(), acc_source_gradient_.data(), sample_vecs_.data(), local_vecs_.data(),
+                  args_->per_edge_source_updates ? nullptr : group_gradient_.data());
+}
+
+template <typename T>
+void Model<T>::end_group() {
+    DynamicRows<T> rows(vectors_->cols());
+    T* source_vec = group_vec_.data();
+    if (!args_->per_edge_source_updates) {
+        // as at the end of objective(), with the learning rate already applied
+        const T* gradient = group_gradient_.data();
+        T mdp = rows.minkowski_dot(source_vec, gradient);
+        T squared_norm = rows.minkowski_dot(gradient, gradient) + mdp * mdp;
+        step(rows, source_vec, mdp, 1, gradient, std::sqrt(std::max(squared_norm, (T) 0)), nullptr, 0);
+    }
+    if (args_->lock_free) {
+        store_ball_point(rows, source_vec, vectors_->row(group_source_));
+    } else {
+        rows.copy(vectors_->row(group_source_), source_vec);
+    }
+    group_source_ = -1;
+}
+
+template <typename T>
+template <class Rows>
+void Model<T>::objective(const Rows& rows, T* source_vec, T* const* sample_vecs, int32_t count, T lr,
+                         T* mdps, T* activations, T* acc_source_gradient, T* group_gradient) {
+    rows.zero(acc_source_gradient);
     // compute the minkowski dot product and activation for each sample
     // ... and also the normalisation factor, z.
-    std::vector<real> mdps(samples.size());
-    std::vector<real> activations(samples.size());
-    real mdp;
-    real activation;
-    real z = 0;
-
-    for (int32_t n = 0; n < samples.size(); n++) {
-        mdp = minkowski_dot(vectors_->at(source), vectors_->at(samples[n]));
-        if (mdp > MAX_MINKOWSKI_DOT) {
-            mdp = MAX_MINKOWSKI_DOT;
-        }
-        mdps[n] = mdp;
-        activation = 1. / (-1 * mdp + std::sqrt(pow(mdp, 2) - 1));
+    T activation;
+    T z = 0;
+
+    for (int32_t n = 0; n < count; n++) {
+        mdps[n] = rows.minkowski_dot(source_vec, sample_vecs[n]);
+        T mdp = std::min(mdps[n], max_minkowski_dot<T>());
+        activation = 1. / (-1 * mdp + std::sqrt(mdp * mdp - 1));
         activations[n] = activation;
         z += activation;
     }
     performance_ += activations[0] / z;
 
-    for (int32_t n = 0; n < samples.size(); n++) {
-        real label = (n == 0);
-        real weight = (-label + activations[n] / z) * (-1. / std::sqrt(pow(mdps[n], 2) - 1));
-        // accumulate the unprojected gradient for the input word vector
-        acc_source_gradient.add(vectors_->at(samples[n]), weight);
-        // update the output word vector
-        sample_gradient = vectors_->at(source);
-        sample_gradient.multiply(lr * weight);
-        sample_gradient.project_onto_tangent_space(vectors_->at(samples[n]));
-        update(vectors_->at(samples[n]), sample_gradient);
+    for (int32_t n = 0; n < count; n++) {
+        T* sample_vec = sample_vecs[n];
+        T mdp = std::min(mdps[n], max_minkowski_dot<T>());
+        T label = (n == 0);
+        T weight = (-label + activations[n] / z) * (-1. / std::sqrt(mdp * mdp - 1));
+        // the gradient for the output word vector is lr * weight * source_vec,
+        // whose projection onto the tangent space at sample_vec is
+        // lr * weight * (source_vec + mdps[n] * sample_vec), of Minkowski norm
+        // |lr * weight| * sqrt(mdps[n]^2 - 1).    Update the output word vector,
+        // and accumulate the unprojected gradient for the input word vector,
+        // in a single pass.
+        T coef = lr * weight;
+        T tangent_norm = std::abs(coef) * std::sqrt(std::max(mdps[n] * mdps[n] - 1, (T) 0));
+        step(rows, sample_vec, coef * mdps[n], coef, source_vec, tangent_norm, acc_source_gradient, weight);
     }
     nexamples_ += 1;
+    if (group_gradient != nullptr) {
+        rows.axpy(group_gradient, lr, acc_source_gradient);
+        return;
+    }
+
+    // the projection of lr * acc_source_gradient onto the tangent space at
+    // source_vec is lr * (acc_source_gradient + mdp * source_vec), where mdp
+    // is the Minkowski dot of the two
+    T mdp = rows.minkowski_dot(source_vec, acc_source_gradient);
+    T squared_norm = rows.minkowski_dot(acc_source_gradient, acc_source_gradient) + mdp * mdp;
+    T tangent_norm = lr * std::sqrt(std::max(squared_norm, (T) 0));
+    step(rows, source_vec, lr * mdp, lr, acc_source_gradient, tangent_norm, nullptr, 0);
+}
+
+template <typename T>
+void Model<T>::batch_objective(const node_t* sources, const node_t* targets, int32_t count,
+                               const std::vector<node_t>& negatives, const std::vector<uint8_t>& excluded,
+                               T lr) {
+    DynamicRows<T> rows(vectors_->cols());
+    const int64_t n = rows.size();
+    const int32_t m = negatives.size();
+    const int32_t points = 2 * count + m;
+    // the points of the sources, the targets and the negatives, in that order
+    batch_nodes_.resize(points);
+    std::copy(sources, sources + count, batch_nodes_.begin());
+    std::copy(targets, targets + count, batch_nodes_.begin() + count);
+    std::copy(negatives.begin(), negatives.end(), batch_nodes_.begin() + 2 * count);
+    batch_points_.resize(points * n);
+    for (int32_t p = 0; p < points; p++) {
+        if (args_->lock_free) {
+            load_ball_point(rows, vectors_->row(batch_nodes_[p]), &batch_points_[p * n]);
+        } else {
+            rows.copy(&batch_points_[p * n], vectors_->row(batch_nodes_[p]));
+        }
+    }
+    const T* source_vecs = &batch_points_[0];
+    const T* target_vecs = &batch_points_[count * n];
+    const T* negative_vecs = &batch_points_[2 * count * n];
+    // the dot products of every source with every negative, as one product
+    // of the sources with the negatives laid out co-ordinate by co-ordinate
+    batch_negatives_.resize(n * m);
+    for (int32_t j = 0; j < m; j++) {
+        for (int64_t k = 0; k < n; k++) {
+            batch_negatives_[k * m + j] = negative_vecs[j * n + k];
+        }
+    }
+    batch_mdps_.resize(count * m);
+    rows.k.minkowski_gemm(batch_mdps_.data(), source_vecs, count, batch_negatives_.data(), m, n);
+    if (int64_t(activations_.size()) < m) {
+        activations_.resize(m);
+    }
+
+    // the gradient of each point (before projection onto its tangent space),
+    // as accumulated for the source by objective()
+    batch_gradients_.assign(points * n, 0);
+    T* source_gradients = &batch_gradients_[0];
+    T* target_gradients = &batch_gradients_[count * n];
+    T* negative_gradients = &batch_gradients_[2 * count * n];
+    for (int32_t b = 0; b < count; b++) {
+        const T* source_vec = source_vecs + b * n;
+        const T* mdps = &batch_mdps_[b * m];
+        const uint8_t* is_excluded = &excluded[b * m];
+        T target_mdp = std::min(rows.minkowski_dot(source_vec, target_vecs + b * n), max_minkowski_dot<T>());
+        T target_activation = 1. / (-1 * target_mdp + std::sqrt(target_mdp * target_mdp - 1));
+        T z = target_activation;
+        for (int32_t j = 0; j < m; j++) {
+            T mdp = std::min(mdps[j], max_minkowski_dot<T>());
+            activations_[j] = is_excluded[j] ? 0 : 1. / (-1 * mdp + std::sqrt(mdp * mdp - 1));
+            z += activations_[j];
+        }
+        performance_ += target_activation / z;
+        T weight = (-1 + target_activation / z) * (-1. / std::sqrt(target_mdp * target_mdp - 1));
+        rows.axpy(source_gradients + b * n, weight, target_vecs + b * n);
+        rows.axpy(target_gradients + b * n, weight, source_vec);
+        for (int32_t j = 0; j < m; j++) {
+            if (is_excluded[j]) {
+                continue;
+            }
+            T mdp = std::min(mdps[j], max_minkowski_dot<T>());
+            weight = (activations_[j] / z) * (-1. / std::sqrt(mdp * mdp - 1));
+            rows.axpy(source_gradients + b * n, weight, negative_vecs + j * n);
+            rows.axpy(negative_gradients + j * n, weight, source_vec);
+        }
+    }
+    nexamples_ += count;
 
-    acc_source_gradient.multiply(lr);
-    acc_source_gradient.project_onto_tangent_space(vectors_->at(source));
-    update(vectors_->at(source), acc_source_gradient);
+    // sum the gradients of each node into its first point, and update that
+    batch_order_.resize(points);
+    for (int32_t p = 0; p < points; p++) {
+        batch_order_[p] = p;
+    }
+    std::sort(batch_order_.begin(), batch_order_.end(), [this](int32_t p, int32_t q) {
+        return batch_nodes_[p] < batch_nodes_[q] || (batch_nodes_[p] == batch_nodes_[q] && p < q);
+    });
+    for (int32_t first = 0; first < points;) {
+        const int32_t p = batch_order_[first];
+        T* point = &batch_points_[p * n];
+        T* gradient = &batch_gradients_[p * n];
+        int32_t next = first + 1;
+        for (; next < points && batch_nodes_[batch_order_[next]] == batch_nodes_[p]; next++) {
+            rows.axpy(gradient, 1, &batch_gradients_[batch_order_[next] * n]);
+        }
+        first = next;
+        // as at the end of objective()
+        T mdp = rows.minkowski_dot(point, gradient);
+        T squared_norm = rows.minkowski_dot(gradient, gradient) + mdp * mdp;
+        step(rows, point, lr * mdp, lr, gradient, lr * std::sqrt(std::max(squared_norm, (T) 0)), nullptr, 0);
+        if (args_->lock_free) {
+            store_ball_point(rows, point, vectors_->row(batch_nodes_[p]));
+        } else {
+            rows.copy(vectors_->row(batch_nodes_[p]), point);
+        }
+    }
 }
 
-real Model::get_performance() {
-    real avg = performance_ / nexamples_;
+template <typename T>
+T Model<T>::get_performance() {
+    T avg = performance_ / nexamples_;
     performance_ = 0.0;
     nexamples_ = 1;
     return avg;
 }
 
+template <typename T, int32_t Dim, int32_t K>
+Model<T, Dim, K>::Model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args) : Model<T>(vectors, args) {
+    assert(vectors->cols() == Dim + 1);
+}
+
+template <typename T, int32_t Dim, int32_t K>
+void Model<T, Dim, K>::nickel_kiela_objective(node_t source, std::vector<node_t>& samples, T lr) {
+    if (samples.size() != K + 1) {
+        Model<T>::nickel_kiela_objective(source, samples, lr);
+        return;
+    }
+    T mdps[K + 1];
+    T activations[K + 1];
+    T acc_source_gradient[Dim + 1];
+    T* sample_vecs[K + 1];
+    T local_vecs[(K + 2) * (Dim + 1)];
+    this->train_edge(FixedRows<T, Dim + 1>(), source, samples, lr, mdps, activations, acc_source_gradient,
+                     sample_vecs, local_vecs);
+}
+
+template <typename T, int32_t Dim, int32_t K>
+void Model<T, Dim, K>::group_edge(std::vector<node_t>& samples, T lr) {
+    if (samples.size() != K + 1) {
+        Model<T>::group_edge(samples, lr);
+        return;
+    }
+    T mdps[K + 1];
+    T activations[K + 1];
+    T acc_source_gradient[Dim + 1];
+    T* sample_vecs[K + 1];
+    T local_vecs[(K + 1) * (Dim + 1)];
+    this->train_samples(FixedRows<T, Dim + 1>(), this->group_vec_.data(), samples, lr, mdps, activations,
+                        acc_source_gradient, sample_vecs, local_vecs,
+                        this->args_->per_edge_source_updates ? nullptr : this->group_gradient_.data());
+}
+
+template <typename T, int32_t Dim, int32_t K>
+std::unique_ptr<Model<T>> create_fixed_model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args) {
+    return std::unique_ptr<Model<T>>(new Model<T, Dim, K>(vectors, args));
+}
+
+template <typename T>
+struct ModelShape {
+    int32_t dimension;
+    int32_t number_negatives;
+    std::unique_ptr<Model<T>> (*create)(std::shared_ptr<Matrix<T>>, std::shared_ptr<Args>);
+};
+
+template <typename T>
+std::unique_ptr<Model<T>> create_model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args) {
+#define SHAPE_ENTRY(DIM, K) {DIM, K, create_fixed_model<T, DIM, K>},
+    static const ModelShape<T> shapes[] = {
+        POINCARE_MODEL_SHAPES(SHAPE_ENTRY)
+    };
+#undef SHAPE_ENTRY
+    for (const ModelShape<T>& shape : shapes) {
+        if (shape.dimension == args->dimension && shape.number_negatives == args->number_negatives) {
+            return shape.create(vectors, args);
+        }
+    }
+    return std::unique_ptr<Model<T>>(new Model<T>(vectors, args));
+}
+
+template class Model<float>;
+template class Model<double>;
+template class Model<long double>;
+
+template std::unique_ptr<Model<float>> create_model(std::shared_ptr<Matrix<float>>, std::shared_ptr<Args>);
+template std::unique_ptr<Model<double>> create_model(std::shared_ptr<Matrix<double>>, std::shared_ptr<Args>);
+template std::unique_ptr<Model<long double>> create_model(std::shared_ptr<Matrix<long double>>, std::shared_ptr<Args>);
+
 }
@@ -2,35 +2,171 @@
 
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "args.h"
+#include "matrix.h"
+#include "node.h"
 #include "vector.h"
-#include "real.h"
 
 namespace poincare {
 
-static const real BALL_MAX_DISTANCE = 1 - 1e-5; // for the Nickel & Kiela style updates
+static const double BALL_MAX_DISTANCE = 1 - 1e-5; // for the Nickel & Kiela style updates
 
-class Model {
+/**
+ * The (dimension, number of negatives) pairs for which a specialised Model is
+ * compiled, as a list of SHAPE(dimension, number_negatives) invocations.
+ * Training with any other pair uses the generic Model.    Override by
+ * defining POINCARE_MODEL_SHAPES when compiling.
+ */
+#ifndef POINCARE_MODEL_SHAPES
+#define POINCARE_MODEL_SHAPES(SHAPE) \
+    SHAPE(2, 10) SHAPE(2, 20) SHAPE(2, 50) \
+    SHAPE(5, 10) SHAPE(5, 20) SHAPE(5, 50) \
+    SHAPE(10, 10) SHAPE(10, 20) SHAPE(10, 50) \
+    SHAPE(20, 10) SHAPE(20, 20) SHAPE(20, 50) \
+    SHAPE(50, 10) SHAPE(50, 20) SHAPE(50, 50) \
+    SHAPE(100, 10) SHAPE(100, 20) SHAPE(100, 50)
+#endif
+
+/**
+ * Model<T> is the generic model, for any dimension and number of negatives;
+ * Model<T, Dim, K> is specialised for manifold dimension Dim and K negatives,
+ * so that its loops have compile-time trip counts and its per-sample
+ * quantities are kept on the stack.
+ */
+template <typename T, int32_t Dim = 0, int32_t K = 0>
+class Model;
+
+template <typename T>
+class Model<T, 0, 0> {
     protected:
-        std::shared_ptr<std::vector<Vector>> vectors_;
+        std::shared_ptr<Matrix<T>> vectors_;
         std::shared_ptr<Args> args_;
-        real performance_;
+        T performance_;
         int64_t nexamples_;
 
+        // scratch space for the generic objective, allocated once so that
+        // training allocates nothing per edge
+        std::vector<T> mdps_;
+        std::vector<T> activations_;
+        std::vector<T> acc_source_gradient_;
+        std::vector<T*> sample_vecs_;
+        std::vector<T> local_vecs_;
+
+        // for a group of edges (see begin_group): the source, its point and
+        // the gradients accumulated for it
+        node_t group_source_;
+        std::vector<T> group_vec_;
+        std::vector<T> group_gradient_;
+
+        // for a mini-batch (see batch_objective): the node of each point
+        // (the sources, then the targets, then the negatives), the points
+        // and their gradients (a row each), the negatives co-ordinate by
+        // co-ordinate, the Minkowski dot products of the sources with the
+        // negatives, and the points in order of node
+        std::vector<node_t> batch_nodes_;
+        std::vector<T> batch_points_;
+        std::vector<T> batch_gradients_;
+        std::vector<T> batch_negatives_;
+        std::vector<T> batch_mdps_;
+        std::vector<int32_t> batch_order_;
+
+        /**
+         * Train on the source and samples, for rows whose co-ordinates are
+         * looped over by `Rows` (see model.cc).    `mdps`, `activations` and
+         * `sample_vecs` provide space for samples.size() entries,
+         * `acc_source_gradient` for a row and `local_vecs` for
+         * samples.size() + 1 rows (only used if args_->lock_free).
+         */
+        template <class Rows>
+        void train_edge(const Rows& rows, node_t source, std::vector<node_t>& samples, T lr,
+                        T* mdps, T* activations, T* acc_source_gradient, T** sample_vecs, T* local_vecs);
+
+        /**
+         * As train_edge, for the source point `source_vec` (a hyperboloid
+         * point, which the caller loads and stores), with room for
+         * samples.size() rows in `local_vecs`.    If `group_gradient` is not
+         * nullptr, the source point is not updated, but lr times its gradient
+         * added to `group_gradient`.
+         */
+        template <class Rows>
+        void train_samples(const Rows& rows, T* source_vec, std::vector<node_t>& samples, T lr,
+                           T* mdps, T* activations, T* acc_source_gradient, T** sample_vecs, T* local_vecs,
+                           T* group_gradient);
+
+        /**
+         * The objective, for the hyperboloid points `source_vec` and
+         * `sample_vecs` (of which there are `count`), which are updated in
+         * place (`source_vec` only if `group_gradient` is nullptr, see
+         * train_samples).
+         */
+        template <class Rows>
+        void objective(const Rows& rows, T* source_vec, T* const* sample_vecs, int32_t count, T lr,
+                       T* mdps, T* activations, T* acc_source_gradient, T* group_gradient);
+
+        /**
+         * Update (in place) the hyperboloid point `point` in the direction of
+         * the tangent vector a * point + b * other, whose Minkowski norm is
+         * `tangent_norm`, as described for update() below.    If `acc` is not
+         * nullptr, first add acc_weight * point to it.    Reads and writes
+         * `point` once (twice for the retraction updates).
+         */
+        template <class Rows>
+        void step(const Rows& rows, T* point, T a, T b, const T* other, T tangent_norm,
+                  T* acc, T acc_weight);
+
     public:
         int64_t update_count;
         int64_t pullback_count;
 
-        Model(std::shared_ptr<std::vector<Vector>> vectors, std::shared_ptr<Args> args);
+        Model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args);
+        virtual ~Model() {}
 
-        void nickel_kiela_objective(int32_t source, std::vector<int32_t>& samples, real lr);
+        /**
+         * Train on the edge from `source` to samples[0], with the negative
+         * samples samples[1], ... (all distinct from one another and from
+         * `source`).    If args_->lock_free, the vectors are points on the
+         * Poincare ball, which are copied to hyperboloid points local to this
+         * model and written back once updated (so that reading a vector while
+         * another thread writes it can not leave the vector off the manifold);
+         * otherwise they are points on the hyperboloid, updated in place.
+         */
+        virtual void nickel_kiela_objective(node_t source, std::vector<node_t>& samples, T lr);
+
+        /**
+         * Train on a group of edges from the same source, keeping the source
+         * point in this model from begin_group(source) until end_group() (so
+         * that the lock of the source, if any, should be held throughout),
+         * with group_edge(samples, lr) for each edge, where `samples` is as
+         * for nickel_kiela_objective.    If args_->per_edge_source_updates,
+         * the source is updated after each edge, as by nickel_kiela_objective;
+         * otherwise its gradients are summed, and applied by end_group() in a
+         * single update.
+         */
+        void begin_group(node_t source);
+        virtual void group_edge(std::vector<node_t>& samples, T lr);
+        void end_group();
+
+        /**
+         * Train on a mini-batch of `count` edges, from sources[b] to
+         * targets[b], sharing the negative samples `negatives`, of which
+         * negatives[j] is a negative for edge b unless
+         * excluded[b * negatives.size() + j] is nonzero.    The Minkowski dot
+         * products of the sources with the negatives are computed as one
+         * matrix product, all from the points as they were before the batch;
+         * the gradients are then summed for each node (which may appear
+         * several times in the batch), and each node updated once.    Uses
+         * the vector kernels for any dimension.
+         */
+        void batch_objective(const node_t* sources, const node_t* targets, int32_t count,
+                             const std::vector<node_t>& negatives, const std::vector<uint8_t>& excluded, T lr);
 
         /**
          * Return a metric on the average performance of this model since the last
          * call to this function (so this function is not idempotent).
          */
-        real get_performance();
+        T get_performance();
 
         /**
          * Update (in place) the hyperboloid point in the direction of its
@@ -41,7 +177,31 @@ class Model {
          * returning to the hyperboloid.    Otherwise, use the exponential map on the
          * hyperboloid.
          */
-        void update(Vector& point, Vector& tangent);
+        void update(Vector<T>& point, Vector<T>& tangent);
 };
 
+template <typename T, int32_t Dim, int32_t K>
+class Model : public Model<T, 0, 0> {
+    public:
+        Model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args);
+
+        /**
+         * As for the generic model; falls back to it if samples.size() != K + 1.
+         */
+        void nickel_kiela_objective(node_t source, std::vector<node_t>& samples, T lr) override;
+
+        /**
+         * As for the generic model; falls back to it if samples.size() != K + 1.
+         */
+        void group_edge(std::vector<node_t>& samples, T lr) override;
+};
+
+/**
+ * Return a new Model for the dimension and number of negatives in `args`:
+ * the specialised Model if one was compiled for them, otherwise the generic
+ * Model.
+ */
+template <typename T>
+std::unique_ptr<Model<T>> create_model(std::shared_ptr<Matrix<T>> vectors, std::shared_ptr<Args> args);
+
 }
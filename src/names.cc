@@ -0,0 +1,130 @@
+#include "names.h"
+#include "binary_io.h"
+
+#include <stdexcept>
+#include <string.h>
+
+namespace poincare {
+
+// the initial number of slots (a power of two)
+constexpr int64_t MIN_SLOTS = 16;
+
+NameTable::NameTable() : offsets_(1, 0) {
+    rehash(MIN_SLOTS);
+}
+
+uint64_t NameTable::hash(const char* name, int64_t length) {
+    // eight bytes at a time, mixing after each as in splitmix64
+    uint64_t h = 0x9e3779b97f4a7c15 ^ uint64_t(length);
+    for (; length >= 8; name += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, name, 8);
+        h = (h ^ word) * 0xbf58476d1ce4e5b9;
+        h ^= h >> 31;
+    }
+    uint64_t word = 0;
+    memcpy(&word, name, length);
+    h = (h ^ word) * 0x94d049bb133111eb;
+    return h ^ (h >> 29);
+}
+
+int64_t NameTable::probe(const char* name, int64_t length, uint64_t name_hash) const {
+    const uint32_t tag = uint32_t(name_hash);
+    for (int64_t s = (name_hash >> 32) & mask_; ; s = (s + 1) & mask_) {
+        const Slot& slot = slots_[s];
+        if (slot.index < 0) {
+            return s;
+        }
+        if (slot.tag == tag && this->length(slot.index) == length && memcmp(data(slot.index), name, length) == 0) {
+            return s;
+        }
+    }
+}
+
+node_t NameTable::insert(const char* name, int64_t length) {
+    const uint64_t name_hash = hash(name, length);
+    int64_t s = probe(name, length, name_hash);
+    if (slots_[s].index >= 0) {
+        return slots_[s].index;
+    }
+    const node_t index = size();
+    chars_.insert(chars_.end(), name, name + length);
+    offsets_.push_back(chars_.size());
+    slots_[s].index = index;
+    slots_[s].tag = uint32_t(name_hash);
+    if (2 * size() > int64_t(slots_.size())) {
+        rehash(2 * slots_.size());
+    }
+    return index;
+}
+
+node_t NameTable::find(const char* name, int64_t length) const {
+    return slots_[probe(name, length, hash(name, length))].index;
+}
+
+node_t NameTable::at(const std::string& name) const {
+    node_t index = find(name);
+    if (index < 0) {
+        throw std::out_of_range("unknown name: " + name);
+    }
+    return index;
+}
+
+void NameTable::reserve(int64_t count) {
+    offsets_.reserve(count + 1);
+    int64_t capacity = slots_.size();
+    while (capacity < 2 * count) {
+        capacity *= 2;
+    }
+    if (capacity > int64_t(slots_.size())) {
+        rehash(capacity);
+    }
+}
+
+void NameTable::rehash(int64_t capacity) {
+    Slot empty = {-1, 0};
+    slots_.assign(capacity, empty);
+    mask_ = capacity - 1;
+    for (node_t i = 0; i < size(); i++) {
+        const uint64_t name_hash = hash(data(i), length(i));
+        int64_t s = (name_hash >> 32) & mask_;
+        while (slots_[s].index >= 0) {
+            s = (s + 1) & mask_;
+        }
+        slots_[s].index = i;
+        slots_[s].tag = uint32_t(name_hash);
+    }
+}
+
+void NameTable::write(std::ostream& out) const {
+    write_array(out, chars_);
+    write_array(out, offsets_);
+}
+
+bool NameTable::read(const char*& cursor, const char* end) {
+    bool valid = read_array(cursor, end, chars_) && read_array(cursor, end, offsets_);
+    // the arena and the offsets should agree
+    valid = valid && !offsets_.empty() && offsets_.front() == 0 && offsets_.back() == int64_t(chars_.size());
+    for (int64_t i = 0; valid && i < size(); i++) {
+        valid = offsets_[i] <= offsets_[i + 1];
+    }
+    if (!valid) {
+        chars_.clear();
+        offsets_.assign(1, 0);
+        rehash(MIN_SLOTS);
+        return false;
+    }
+    // the index is not stored, but rebuilt from the arena
+    int64_t capacity = MIN_SLOTS;
+    while (capacity < 2 * size()) {
+        capacity *= 2;
+    }
+    rehash(capacity);
+    return true;
+}
+
+int64_t NameTable::bytes() const {
+    return chars_.capacity() + offsets_.capacity() * sizeof(int64_t) + slots_.size() * sizeof(Slot);
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "node.h"
+
+namespace poincare {
+
+class NameTable {
+    /**
+     * A set of names, numbered 0, 1, ... in the order they were added.    The
+     * names are stored once, end to end in a single arena of characters, and
+     * indexed by an open-addressing hash table (linear probing, at most half
+     * full) whose slots hold the number of the name and part of its hash, so
+     * that the arena is only read to confirm a match.
+     */
+
+    public:
+        NameTable();
+
+        int64_t size() const { return offsets_.size() - 1; }
+
+        /**
+         * Return the number of the name, adding it if it is new.
+         */
+        node_t insert(const char* name, int64_t length);
+        node_t insert(const std::string& name) { return insert(name.data(), name.size()); }
+
+        /**
+         * Return the number of the name, or -1 if it is not present.
+         */
+        node_t find(const char* name, int64_t length) const;
+        node_t find(const std::string& name) const { return find(name.data(), name.size()); }
+
+        /**
+         * As for find, but raising an out_of_range if the name is not present.
+         */
+        node_t at(const std::string& name) const;
+
+        /**
+         * Return name number i (a copy, or a pointer to its characters and
+         * their number).
+         */
+        std::string name(node_t i) const { return std::string(data(i), length(i)); }
+        const char* data(node_t i) const { return chars_.data() + offsets_[i]; }
+        int64_t length(node_t i) const { return offsets_[i + 1] - offsets_[i]; }
+
+        /**
+         * Prepare for a total of `count` names.
+         */
+        void reserve(int64_t count);
+
+        /**
+         * Write the names to `out`, for read (which rebuilds their index).
+         */
+        void write(std::ostream& out) const;
+
+        /**
+         * Replace the names by those written by write at `cursor` (reading no
+         * further than `end`, and advancing `cursor` past them).    Return
+         * false, leaving this empty, if these are malformed.
+         */
+        bool read(const char*& cursor, const char* end);
+
+        /**
+         * Return the number of bytes used (by the arena and the index).
+         */
+        int64_t bytes() const;
+
+    protected:
+        struct Slot {
+            node_t index; // -1 if empty
+            uint32_t tag; // the bottom bits of the hash of the name
+        };
+
+        static uint64_t hash(const char* name, int64_t length);
+
+        /**
+         * Return the slot holding the name, or the empty slot where it would
+         * go.
+         */
+        int64_t probe(const char* name, int64_t length, uint64_t name_hash) const;
+
+        /**
+         * Re-index the names in a table of `capacity` slots (a power of two).
+         */
+        void rehash(int64_t capacity);
+
+        std::vector<char> chars_;
+        // name i is chars_[offsets_[i]], ..., chars_[offsets_[i + 1] - 1]
+        std::vector<int64_t> offsets_;
+        std::vector<Slot> slots_;
+        int64_t mask_;
+};
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace poincare {
+
+// The integer type enumerating the nodes (and so indexing their names,
+// counts, vectors and locks, and holding the endpoints of the edges and the
+// negative samples).    It is 32 bits unless compiled with
+// POINCARE_64BIT_NODES (the CMake option of that name), for graphs of 2^31
+// or more nodes; this doubles the memory used by the edges.    The edges are
+// always indexed by int64_t.
+#ifdef POINCARE_64BIT_NODES
+typedef int64_t node_t;
+#else
+typedef int32_t node_t;
+#endif
+
+}
@@ -0,0 +1,53 @@
+#include "partitions.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace poincare {
+
+PartitionSchedule::PartitionSchedule(const Digraph& digraph, int32_t partitions) : partitions_(partitions) {
+    if (partitions <= 0) {
+        throw std::invalid_argument("the number of partitions must be positive");
+    }
+    // bucket the edges, keeping only the non-empty buckets
+    std::vector<Bucket> all_buckets(int64_t(partitions) * partitions);
+    for (int64_t i = 0; i < digraph.edge_count(); i++) {
+        int32_t source_partition = partition(digraph.edge_sources[i]);
+        int32_t target_partition = partition(digraph.edge_targets[i]);
+        all_buckets[int64_t(source_partition) * partitions + target_partition].edges.push_back(i);
+    }
+    for (int64_t b = 0; b < int64_t(all_buckets.size()); b++) {
+        if (!all_buckets[b].edges.empty()) {
+            all_buckets[b].source_partition = b / partitions;
+            all_buckets[b].target_partition = b % partitions;
+            buckets_.push_back(std::move(all_buckets[b]));
+        }
+    }
+    // form the rounds greedily, largest buckets first
+    std::vector<int32_t> remaining(buckets_.size());
+    for (int64_t b = 0; b < int64_t(buckets_.size()); b++) {
+        remaining[b] = b;
+    }
+    std::stable_sort(remaining.begin(), remaining.end(), [this](int32_t a, int32_t b) {
+        return buckets_[a].edges.size() > buckets_[b].edges.size();
+    });
+    while (!remaining.empty()) {
+        std::vector<bool> busy(partitions, false);
+        std::vector<int32_t> round;
+        std::vector<int32_t> deferred;
+        for (int32_t b : remaining) {
+            const Bucket& bucket = buckets_[b];
+            if (busy[bucket.source_partition] || busy[bucket.target_partition]) {
+                deferred.push_back(b);
+                continue;
+            }
+            busy[bucket.source_partition] = true;
+            busy[bucket.target_partition] = true;
+            round.push_back(b);
+        }
+        rounds_.push_back(round);
+        remaining.swap(deferred);
+    }
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "digraph.h"
+
+namespace poincare {
+
+/**
+ * The edges whose source lies in one partition of the nodes and whose target
+ * lies in another (or the same) partition.
+ */
+struct Bucket {
+    int32_t source_partition;
+    int32_t target_partition;
+    std::vector<int64_t> edges; // indices into Digraph::edges, in order
+};
+
+class PartitionSchedule {
+    /**
+     * Splits the nodes into partitions (node n in partition n % partitions)
+     * and groups the edges into buckets by the partitions of their source
+     * and target.    The (non-empty) buckets are scheduled in rounds, such that
+     * no two buckets of a round involve the same partition.    Training the
+     * buckets of a round in parallel, with negatives drawn from the
+     * partitions of the bucket, then touches each vector from at most one
+     * thread, without locking.    The rounds are formed greedily, largest
+     * buckets first, and each round lists its buckets largest first.
+     */
+
+    public:
+        PartitionSchedule(const Digraph& digraph, int32_t partitions);
+
+        int32_t partitions() const { return partitions_; }
+        int32_t partition(node_t node) const { return node % partitions_; }
+
+        const std::vector<Bucket>& buckets() const { return buckets_; }
+
+        /**
+         * Return the rounds, each a list of indices into buckets().
+         */
+        const std::vector<std::vector<int32_t>>& rounds() const { return rounds_; }
+
+    protected:
+        int32_t partitions_;
+        std::vector<Bucket> buckets_;
+        std::vector<std::vector<int32_t>> rounds_;
+};
+
+}
@@ -2,33 +2,83 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
-#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // how many tokens to process before reporting on performance
 constexpr int32_t REPORTING_INTERVAL = 250;
+// for ordered locking (and the sources of grouped training), how many times
+// to retry a lock (or, with sampler threads, a full or empty ring) before
+// yielding
+constexpr int32_t LOCK_SPINS = 64;
+// the least number of targets of a node for which to filter them with a bit
+// filter before searching
+constexpr int64_t EXCLUSION_FILTER_DEGREE = 32;
+// how many consecutive edges a thread claims at a time
+constexpr int64_t EDGE_CHUNK = 64;
+// for grouped training, how many consecutive sources a thread claims at a time
+constexpr int64_t SOURCE_CHUNK = 4;
+// with sampler threads, the number of edges each ring holds
+constexpr int64_t RING_CAPACITY = 4 * EDGE_CHUNK;
 
 namespace poincare {
 
-    Poincare::Poincare(std::shared_ptr<Args> args) {
-        args_ = args;
-        performance = 0;
+namespace {
+
+// Wait a little before the next of several attempts (numbered from 1) at
+// something another thread must make possible: spin at first, then yield.
+void back_off(int32_t attempt) {
+    if (attempt < LOCK_SPINS) {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#endif
+    } else {
+        std::this_thread::yield();
     }
+}
+
+}
 
-void Poincare::save_vectors(std::string fn) {
+template <typename T>
+Poincare<T>::Poincare(std::shared_ptr<Args> args) {
+    args_ = args;
+    performance = 0;
+    edges_trained_ = 0;
+    edges_skipped_ = 0;
+    lock_wait_nanoseconds_ = 0;
+    sample_wait_nanoseconds_ = 0;
+    room_wait_nanoseconds_ = 0;
+    ring_occupancy_ = 0;
+    ring_pops_ = 0;
+}
+
+template <typename T>
+void Poincare<T>::save_vectors(std::string fn) {
     std::ofstream ofs(fn);
     if (!ofs.is_open()) {
         throw std::invalid_argument(fn + " cannot be opened!");
     }
-    for (int32_t i = 0; i < digraph->node_count(); i++) {
-        std::string name = (digraph->enumeration2node[i])->name;
-        Vector vector(vectors_->at(i)); // a copy
-        vector.to_ball_point();
-        ofs << name << " " << vector << std::endl;
+    // in the order of the training file, even if the nodes were relabelled
+    for (node_t n = 0; n < digraph->node_count(); n++) {
+        const node_t i = digraph->file_order.empty() ? n : digraph->file_order[n];
+        Vector<T> row(vectors_->row(i), vectors_->cols());
+        Vector<T> vector(row); // a copy
+        if (!args_->lock_free) {
+            vector.to_ball_point();
+        }
+        ofs.write(digraph->names.data(i), digraph->names.length(i));
+        ofs << " " << vector << std::endl;
     }
     ofs.close();
 }
 
-void Poincare::load_vectors(std::string fn) {
+template <typename T>
+void Poincare<T>::load_vectors(std::string fn) {
     std::ifstream in(fn);
     if (!in.is_open()) {
         throw std::invalid_argument(fn + " cannot be opened!");
@@ -39,21 +89,24 @@ void Poincare::load_vectors(std::string fn) {
         std::stringstream line_stream(line);
         // count the fields
         int col = 0;
-        int32_t offset;
+        T* row;
         while (std::getline(line_stream, field, ' ')) {
             if (col == 0) {
-                offset = (digraph->name2node).at(field)->enumeration;
+                row = vectors_->row(digraph->names.at(field));
             } else {
-                vectors_->at(offset)[col - 1] = std::stold(field);
+                row[col - 1] = std::stold(field);
             }
             col++;
         }
-        vectors_->at(offset).to_hyperboloid_point();
+        if (!args_->lock_free) {
+            Vector<T>(row, vectors_->cols()).to_hyperboloid_point();
+        }
     }
     in.close();
 }
 
-void Poincare::print_info(real progress, real lr) {
+template <typename T>
+void Poincare<T>::print_info(T progress, T lr) {
     if (args_->verbose) {
         std::cerr << std::fixed;
         std::cerr << "\r" << std::setw(5) << std::setprecision(1) << 100 * progress << "%";
@@ -63,60 +116,582 @@ void Poincare::print_info(real progress, real lr) {
     }
 }
 
-bool Poincare::obtain_vectors(int32_t source, int32_t target, std::vector<int32_t>& samples, std::minstd_rand& rng) {
-    if (!vector_flags_->at(source).try_lock()) {
+template <typename T>
+bool Poincare<T>::obtain_vectors(node_t source, node_t target, std::vector<node_t>& samples,
+                                 std::vector<int64_t>& slots, Rng& rng, RejectionStats& stats) {
+    const size_t held = slots.size();
+    if (source == target || !lock_vector(source, slots)) {
         return false;
     }
-    if (!vector_flags_->at(target).try_lock()) {
-        vector_flags_->at(source).unlock();
+    if (!lock_vector(target, slots)) {
+        release_vectors(slots, held);
         return false;
     }
-    samples.clear();
-    samples.push_back(target);
+    // draw the negatives still needed into the end of `samples`, keeping
+    // those that are new and can be locked, until the draws allowed run out
+    const int32_t required = args_->number_negatives + 1;
+    int64_t budget = int64_t(args_->max_negative_attempts) * args_->number_negatives;
+    samples.resize(required);
+    samples[0] = target;
+    int32_t filled = 1;
+    while (filled < required && budget > 0) {
+        int32_t end = filled + sampler->sample_batch(*exclusions_, source, required - filled, &samples[filled],
+                                                     rng, stats, budget);
+        for (int32_t i = filled; i < end; i++) {
+            node_t next_negative = samples[i];
+            if (next_negative == source || std::find(&samples[0], &samples[filled], next_negative) != &samples[filled]) {
+                continue;
+            }
+            if (!lock_vector(next_negative, slots)) {
+                stats.lock_failures++;
+                continue;
+            }
+            samples[filled++] = next_negative;
+        }
+    }
+    truncate_samples(samples, filled, stats);
+    return true;
+}
 
-    while (samples.size() < args_->number_negatives + 1) {
-        Node* source_node = (digraph->enumeration2node)[source];
-        auto next_negative = sampler->get_sample(source_node->target_enums, rng);
-        if (vector_flags_->at(next_negative).try_lock()) {
-            samples.push_back(next_negative);
+template <typename T>
+bool Poincare<T>::lock_drawn_vectors(node_t source, std::vector<node_t>& samples, std::vector<int64_t>& slots,
+                                     RejectionStats& stats) {
+    if (source == samples[0] || !lock_vector(source, slots)) {
+        return false;
+    }
+    if (!lock_vector(samples[0], slots)) {
+        release_vectors(slots);
+        return false;
+    }
+    int32_t filled = 1;
+    for (size_t i = 1; i < samples.size(); i++) {
+        if (!lock_vector(samples[i], slots)) {
+            stats.lock_failures++;
+            continue;
         }
+        samples[filled++] = samples[i];
+    }
+    if (filled < int32_t(samples.size())) {
+        stats.shortfalls++;
+        stats.missing += samples.size() - filled;
     }
+    samples.resize(filled);
     return true;
 }
 
-void Poincare::release_vectors(int32_t source, std::vector<int32_t>& samples) {
-    for (int32_t n = 0; n < samples.size(); n++) {
-        vector_flags_->at(samples[n]).unlock();
+template <typename T>
+bool Poincare<T>::lock_vector(node_t node, std::vector<int64_t>& slots) {
+    int64_t slot = locks_->slot(node);
+    if (std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+        return true;
+    }
+    if (!locks_->try_lock(slot)) {
+        return false;
+    }
+    slots.push_back(slot);
+    return true;
+}
+
+template <typename T>
+int64_t Poincare<T>::lock_vectors_in_order(node_t source, std::vector<node_t>& samples, std::vector<int64_t>& slots) {
+    slots.clear();
+    slots.push_back(locks_->slot(source));
+    for (node_t sample : samples) {
+        slots.push_back(locks_->slot(sample));
+    }
+    return lock_slots_in_order(slots);
+}
+
+template <typename T>
+int64_t Poincare<T>::lock_slots_in_order(std::vector<int64_t>& slots) {
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    int64_t waited = 0;
+    for (int64_t slot : slots) {
+        waited += wait_for_lock(slot);
+    }
+    return waited;
+}
+
+template <typename T>
+int64_t Poincare<T>::wait_for_lock(int64_t slot) {
+    if (locks_->try_lock(slot)) {
+        return 0;
+    }
+    auto wait_start = std::chrono::steady_clock::now();
+    for (int32_t attempt = 1; !locks_->try_lock(slot); attempt++) {
+        back_off(attempt);
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_start).count();
+}
+
+template <typename T>
+void Poincare<T>::release_vectors(std::vector<int64_t>& slots, size_t keep) {
+    for (size_t i = keep; i < slots.size(); i++) {
+        locks_->unlock(slots[i]);
+    }
+    slots.resize(keep);
+}
+
+template <typename T>
+void Poincare<T>::draw_samples(node_t source, node_t target, std::vector<node_t>& samples, Rng& rng,
+                               RejectionStats& stats) {
+    // draw the negatives still needed into the end of `samples`, keeping
+    // those that are new, until the draws allowed run out
+    const int32_t required = args_->number_negatives + 1;
+    int64_t budget = int64_t(args_->max_negative_attempts) * args_->number_negatives;
+    samples.resize(required);
+    samples[0] = target;
+    int32_t filled = 1;
+    while (filled < required && budget > 0) {
+        int32_t end = filled + sampler->sample_batch(*exclusions_, source, required - filled, &samples[filled],
+                                                     rng, stats, budget);
+        for (int32_t i = filled; i < end; i++) {
+            node_t next_negative = samples[i];
+            if (next_negative != source && std::find(&samples[0], &samples[filled], next_negative) == &samples[filled]) {
+                samples[filled++] = next_negative;
+            }
+        }
+    }
+    truncate_samples(samples, filled, stats);
+}
+
+template <typename T>
+void Poincare<T>::draw_shared_negatives(std::vector<node_t>& negatives, std::vector<int64_t>* slots, Rng& rng,
+                                        RejectionStats& stats) {
+    static const std::vector<node_t> nothing_excluded;
+    const int32_t required = args_->number_negatives;
+    negatives.clear();
+    for (int64_t attempts = int64_t(args_->max_negative_attempts) * required;
+         int32_t(negatives.size()) < required && attempts > 0; attempts--) {
+        node_t next_negative = sampler->get_sample(nothing_excluded, rng);
+        if (std::find(negatives.begin(), negatives.end(), next_negative) != negatives.end()) {
+            continue;
+        }
+        if (slots != nullptr && !lock_vector(next_negative, *slots)) {
+            stats.lock_failures++;
+            continue;
+        }
+        stats.samples++;
+        negatives.push_back(next_negative);
+    }
+}
+
+template <typename T>
+void Poincare<T>::truncate_samples(std::vector<node_t>& samples, int32_t filled, RejectionStats& stats) {
+    const int32_t required = args_->number_negatives + 1;
+    if (filled < required) {
+        stats.shortfalls++;
+        stats.missing += required - filled;
+    }
+    samples.resize(filled);
+}
+
+template <typename T>
+void Poincare<T>::epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                               WorkQueues& queues, std::atomic<int64_t>& edges_started) {
+    Rng rng(seed);
+    const int64_t total_edges = digraph->edge_count();
+    const node_t* edge_sources = digraph->edge_sources.data();
+    const node_t* edge_targets = digraph->edge_targets.data();
+    const int64_t* edge_order = edge_order_.empty() ? nullptr : edge_order_.data();
+
+    int64_t iter_count = 0; // number processed so far
+    int64_t skipped = 0; // number skipped due to locking
+    int64_t waited = 0; // nanoseconds spent waiting for locks
+    RejectionStats rejections;
+    T lr = start_lr;
+    T progress = 0.;
+    std::vector<node_t>& samples = thread_samples_[thread_id];
+    std::vector<int64_t>& slots = thread_slots_[thread_id];
+    model.update_count = 1;
+    model.pullback_count = 0;
+    int64_t begin, end;
+    while (queues.claim(thread_id, begin, end)) {
+        int64_t started = edges_started.fetch_add(end - begin);
+        for (int64_t i = begin; i < end; i++) {
+            iter_count++;
+            const int64_t edge = edge_order == nullptr ? i : edge_order[i];
+            node_t source_enum = edge_sources[edge];
+            node_t target_enum = edge_targets[edge];
+            progress = T(started + i - begin) / total_edges;
+            lr = start_lr * (1.0 - progress) + end_lr * progress;
+            samples.clear();
+            if (args_->lock_free) {
+                draw_samples(source_enum, target_enum, samples, rng, rejections);
+                model.nickel_kiela_objective(source_enum, samples, lr);
+            } else if (args_->ordered_locking) {
+                if (source_enum == target_enum) {
+                    skipped++;
+                    continue;
+                }
+                draw_samples(source_enum, target_enum, samples, rng, rejections);
+                waited += lock_vectors_in_order(source_enum, samples, slots);
+                model.nickel_kiela_objective(source_enum, samples, lr);
+                release_vectors(slots);
+            } else {
+                if (!obtain_vectors(source_enum, target_enum, samples, slots, rng, rejections)) {
+                    // couldn't obtain one of the necessary locks, so skip!
+                    skipped++;
+                    continue;
+                }
+                model.nickel_kiela_objective(source_enum, samples, lr);
+                release_vectors(slots);
+            }
+            if (thread_id == 0) {
+                // only thread 0 is responsible for printing progress info
+                if (iter_count % REPORTING_INTERVAL == 0) {
+                    print_info(progress, lr);
+                }
+            }
+        }
+    }
+    thread_performance_[thread_id] = model.get_performance();
+    thread_rejections_[thread_id] = rejections;
+    edges_trained_ += iter_count - skipped;
+    edges_skipped_ += skipped;
+    lock_wait_nanoseconds_ += waited;
+    if (thread_id == 0) {
+        print_info(progress, lr);
+        std::cerr << std::endl;
+        std::cerr << std::setfill('0');
+        std::cerr << "Thread 0: skipped " << std::setw(6) << skipped << "/" << std::setw(6) << iter_count << " problems; ";
+        std::cerr << "pullbacks for " << std::setw(6) << model.pullback_count << "/" << std::setw(6) << model.update_count << " updates.\n";
+    }
+}
+
+template <typename T>
+void Poincare<T>::grouped_epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                                       WorkQueues& queues, std::atomic<int64_t>& edges_started) {
+    Rng rng(seed);
+    const int64_t total_edges = digraph->edge_count();
+    const int64_t* target_offsets = digraph->target_offsets.data();
+    const node_t* target_enums = digraph->target_enums.data();
+
+    int64_t iter_count = 0; // number processed so far
+    int64_t skipped = 0; // number skipped due to locking
+    int64_t waited = 0; // nanoseconds spent waiting for the locks of sources
+    RejectionStats rejections;
+    T lr = start_lr;
+    T progress = 0.;
+    std::vector<node_t>& samples = thread_samples_[thread_id];
+    std::vector<int64_t>& slots = thread_slots_[thread_id];
+    model.update_count = 1;
+    model.pullback_count = 0;
+    int64_t begin, end;
+    while (queues.claim(thread_id, begin, end)) {
+        int64_t started = edges_started.fetch_add(target_offsets[end] - target_offsets[begin]);
+        int64_t position = started;
+        for (node_t source_enum = begin; source_enum < end; source_enum++) {
+            if (target_offsets[source_enum] == target_offsets[source_enum + 1]) {
+                continue;
+            }
+            if (!args_->lock_free) {
+                // holding no locks, so waiting can not deadlock
+                int64_t slot = locks_->slot(source_enum);
+                waited += wait_for_lock(slot);
+                slots.push_back(slot);
+            }
+            model.begin_group(source_enum);
+            for (int64_t i = target_offsets[source_enum]; i < target_offsets[source_enum + 1]; i++) {
+                iter_count++;
+                node_t target_enum = target_enums[i];
+                progress = T(position++) / total_edges;
+                lr = start_lr * (1.0 - progress) + end_lr * progress;
+                samples.clear();
+                if (source_enum == target_enum) {
+                    skipped++;
+                    continue;
+                }
+                if (args_->lock_free) {
+                    draw_samples(source_enum, target_enum, samples, rng, rejections);
+                    model.group_edge(samples, lr);
+                } else {
+                    if (!obtain_vectors(source_enum, target_enum, samples, slots, rng, rejections)) {
+                        // couldn't obtain the lock of the target, so skip!
+                        skipped++;
+                        continue;
+                    }
+                    model.group_edge(samples, lr);
+                    release_vectors(slots, 1);
+                }
+                if (thread_id == 0) {
+                    // only thread 0 is responsible for printing progress info
+                    if (iter_count % REPORTING_INTERVAL == 0) {
+                        print_info(progress, lr);
+                    }
+                }
+            }
+            model.end_group();
+            if (!args_->lock_free) {
+                release_vectors(slots);
+            }
+        }
+    }
+    thread_performance_[thread_id] = model.get_performance();
+    thread_rejections_[thread_id] = rejections;
+    edges_trained_ += iter_count - skipped;
+    edges_skipped_ += skipped;
+    lock_wait_nanoseconds_ += waited;
+    if (thread_id == 0) {
+        print_info(progress, lr);
+        std::cerr << std::endl;
+        std::cerr << std::setfill('0');
+        std::cerr << "Thread 0: skipped " << std::setw(6) << skipped << "/" << std::setw(6) << iter_count << " problems; ";
+        std::cerr << "pullbacks for " << std::setw(6) << model.pullback_count << "/" << std::setw(6) << model.update_count << " updates.\n";
+    }
+}
+
+template <typename T>
+void Poincare<T>::batch_epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                                     WorkQueues& queues, std::atomic<int64_t>& edges_started) {
+    Rng rng(seed);
+    const int64_t total_edges = digraph->edge_count();
+    const node_t* edge_sources = digraph->edge_sources.data();
+    const node_t* edge_targets = digraph->edge_targets.data();
+    const int64_t* edge_order = edge_order_.empty() ? nullptr : edge_order_.data();
+    const int32_t batch_size = args_->batch_size;
+
+    int64_t iter_count = 0; // number processed so far
+    int64_t skipped = 0; // number skipped due to locking
+    int64_t waited = 0; // nanoseconds spent waiting for locks
+    RejectionStats rejections;
+    T lr = start_lr;
+    T progress = 0.;
+    std::vector<node_t>& negatives = thread_samples_[thread_id];
+    std::vector<int64_t>& slots = thread_slots_[thread_id];
+    std::vector<node_t> sources, targets;
+    std::vector<uint8_t> excluded;
+    sources.reserve(batch_size);
+    targets.reserve(batch_size);
+    excluded.reserve(int64_t(batch_size) * args_->number_negatives);
+    model.update_count = 1;
+    model.pullback_count = 0;
+
+    // lock what is needed, draw the negatives and train the edges collected
+    auto train_batch = [&]() {
+        if (args_->lock_free) {
+            draw_shared_negatives(negatives, nullptr, rng, rejections);
+        } else if (args_->ordered_locking) {
+            draw_shared_negatives(negatives, nullptr, rng, rejections);
+            slots.clear();
+            for (int32_t b = 0; b < int32_t(sources.size()); b++) {
+                slots.push_back(locks_->slot(sources[b]));
+                slots.push_back(locks_->slot(targets[b]));
+            }
+            for (node_t negative : negatives) {
+                slots.push_back(locks_->slot(negative));
+            }
+            waited += lock_slots_in_order(slots);
+        } else {
+            // keep the edges whose source and target can both be locked
+            int32_t kept = 0;
+            for (int32_t b = 0; b < int32_t(sources.size()); b++) {
+                const size_t held = slots.size();
+                if (!lock_vector(sources[b], slots) || !lock_vector(targets[b], slots)) {
+                    release_vectors(slots, held);
+                    skipped++;
+                    continue;
+                }
+                sources[kept] = sources[b];
+                targets[kept] = targets[b];
+                kept++;
+            }
+            sources.resize(kept);
+            targets.resize(kept);
+            draw_shared_negatives(negatives, &slots, rng, rejections);
+        }
+        const int32_t count = sources.size();
+        const int32_t m = negatives.size();
+        if (m < args_->number_negatives) {
+            rejections.shortfalls += count;
+            rejections.missing += int64_t(count) * (args_->number_negatives - m);
+        }
+        // a negative is excluded for an edge if it is its source, its
+        // target, or any other target of its source
+        excluded.assign(int64_t(count) * m, 0);
+        for (int32_t b = 0; b < count; b++) {
+            for (int32_t j = 0; j < m; j++) {
+                if (negatives[j] == sources[b] || negatives[j] == targets[b]
+                    || exclusions_->excludes(sources[b], negatives[j])) {
+                    excluded[int64_t(b) * m + j] = 1;
+                    rejections.rejections++;
+                }
+            }
+        }
+        if (count > 0) {
+            model.batch_objective(sources.data(), targets.data(), count, negatives, excluded, lr);
+        }
+        if (!args_->lock_free) {
+            release_vectors(slots);
+        }
+        sources.clear();
+        targets.clear();
+    };
+
+    int64_t begin, end;
+    while (queues.claim(thread_id, begin, end)) {
+        int64_t started = edges_started.fetch_add(end - begin);
+        for (int64_t i = begin; i < end; i++) {
+            iter_count++;
+            const int64_t edge = edge_order == nullptr ? i : edge_order[i];
+            node_t source_enum = edge_sources[edge];
+            node_t target_enum = edge_targets[edge];
+            progress = T(started + i - begin) / total_edges;
+            lr = start_lr * (1.0 - progress) + end_lr * progress;
+            if (source_enum == target_enum) {
+                skipped++;
+                continue;
+            }
+            sources.push_back(source_enum);
+            targets.push_back(target_enum);
+            if (int32_t(sources.size()) == batch_size) {
+                train_batch();
+            }
+            if (thread_id == 0) {
+                // only thread 0 is responsible for printing progress info
+                if (iter_count % REPORTING_INTERVAL == 0) {
+                    print_info(progress, lr);
+                }
+            }
+        }
+    }
+    if (!sources.empty()) {
+        train_batch();
+    }
+    thread_performance_[thread_id] = model.get_performance();
+    thread_rejections_[thread_id] = rejections;
+    edges_trained_ += iter_count - skipped;
+    edges_skipped_ += skipped;
+    lock_wait_nanoseconds_ += waited;
+    if (thread_id == 0) {
+        print_info(progress, lr);
+        std::cerr << std::endl;
+        std::cerr << std::setfill('0');
+        std::cerr << "Thread 0: skipped " << std::setw(6) << skipped << "/" << std::setw(6) << iter_count << " problems; ";
+        std::cerr << "pullbacks for " << std::setw(6) << model.pullback_count << "/" << std::setw(6) << model.update_count << " updates.\n";
+    }
+}
+
+template <typename T>
+void Poincare<T>::sampler_thread(int32_t sampler_id, uint32_t seed, WorkQueues& queues,
+                                 std::atomic<int64_t>& edges_started) {
+    Rng rng(seed);
+    const node_t* edge_sources = digraph->edge_sources.data();
+    const node_t* edge_targets = digraph->edge_targets.data();
+    const int64_t* edge_order = edge_order_.empty() ? nullptr : edge_order_.data();
+
+    int64_t waited = 0; // nanoseconds spent waiting for room in the rings
+    RejectionStats rejections;
+    std::vector<node_t> samples;
+    samples.reserve(args_->number_negatives + 1);
+    // append to the ring of the worker, waiting while it is full
+    auto push = [&](int32_t worker, int64_t position, node_t source, node_t target) {
+        const node_t* negatives = samples.data() + 1;
+        const int32_t count = samples.size() - 1;
+        if (rings_[worker]->try_push(position, source, target, negatives, count)) {
+            return;
+        }
+        auto wait_start = std::chrono::steady_clock::now();
+        for (int32_t attempt = 1; !rings_[worker]->try_push(position, source, target, negatives, count); attempt++) {
+            back_off(attempt);
+        }
+        waited += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_start).count();
+    };
+
+    // serve the workers in turn, a chunk of edges at a time
+    std::vector<int32_t> workers;
+    for (int32_t worker = sampler_id; worker < args_->threads; worker += args_->sampler_threads) {
+        workers.push_back(worker);
     }
-    vector_flags_->at(source).unlock();
+    std::vector<bool> finished(workers.size(), false);
+    size_t remaining = workers.size();
+    while (remaining > 0) {
+        for (size_t w = 0; w < workers.size(); w++) {
+            if (finished[w]) {
+                continue;
+            }
+            int64_t begin, end;
+            if (!queues.claim(workers[w], begin, end)) {
+                samples.assign(1, 0);
+                push(workers[w], -1, 0, 0);
+                finished[w] = true;
+                remaining--;
+                continue;
+            }
+            int64_t started = edges_started.fetch_add(end - begin);
+            for (int64_t i = begin; i < end; i++) {
+                const int64_t edge = edge_order == nullptr ? i : edge_order[i];
+                node_t source_enum = edge_sources[edge];
+                node_t target_enum = edge_targets[edge];
+                samples.clear();
+                draw_samples(source_enum, target_enum, samples, rng, rejections);
+                push(workers[w], started + i - begin, source_enum, target_enum);
+            }
+        }
+    }
+    sampler_rejections_[sampler_id] = rejections;
+    room_wait_nanoseconds_ += waited;
 }
 
-void Poincare::epoch_thread(int32_t thread_id, uint32_t seed, real start_lr, real end_lr) {
-    std::minstd_rand rng(1 + seed); // seed 0 and 1 coincide for minstd_rand
-    const int64_t edges_per_thread = digraph->edges.size() / args_->threads;
-    Model model(vectors_, args_);
+template <typename T>
+void Poincare<T>::pipelined_epoch_thread(int32_t thread_id, T start_lr, T end_lr, Model<T>& model) {
+    SampleRing& ring = *rings_[thread_id];
+    const int64_t total_edges = digraph->edge_count();
 
     int64_t iter_count = 0; // number processed so far
     int64_t skipped = 0; // number skipped due to locking
-    real lr = start_lr;
-    real progress = 0.;
-    std::vector<int32_t> samples;
-    Edge* edge;
-    for (int64_t i = thread_id; i < digraph->edges.size(); i=i+args_->threads) {
-        edge = (digraph->edges)[i];
+    int64_t waited = 0; // nanoseconds spent waiting for locks
+    int64_t starved = 0; // nanoseconds spent waiting for edges
+    int64_t occupancy = 0;
+    RejectionStats rejections;
+    T lr = start_lr;
+    T progress = 0.;
+    std::vector<node_t>& samples = thread_samples_[thread_id];
+    std::vector<int64_t>& slots = thread_slots_[thread_id];
+    model.update_count = 1;
+    model.pullback_count = 0;
+    while (true) {
+        int64_t position;
+        node_t source_enum, target_enum;
+        int32_t count;
+        samples.resize(args_->number_negatives + 1);
+        if (!ring.try_pop(position, source_enum, target_enum, &samples[1], count)) {
+            auto wait_start = std::chrono::steady_clock::now();
+            for (int32_t attempt = 1; !ring.try_pop(position, source_enum, target_enum, &samples[1], count); attempt++) {
+                back_off(attempt);
+            }
+            starved += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_start).count();
+        }
+        if (position < 0) {
+            // the end of the epoch
+            break;
+        }
+        occupancy += ring.size();
         iter_count++;
-        int32_t source_enum = (edge->source).enumeration;
-        int32_t target_enum = (edge->target).enumeration;
-        progress = real(iter_count) / edges_per_thread;
+        samples[0] = target_enum;
+        samples.resize(count + 1);
+        progress = T(position) / total_edges;
         lr = start_lr * (1.0 - progress) + end_lr * progress;
-        samples.clear();
-        if (!obtain_vectors(source_enum, target_enum, samples, rng)) {
-            // couldn't obtain one of the necessary locks, so skip!
-            skipped++;
-            continue;
+        if (args_->lock_free) {
+            model.nickel_kiela_objective(source_enum, samples, lr);
+        } else if (args_->ordered_locking) {
+            if (source_enum == target_enum) {
+                skipped++;
+                continue;
+            }
+            waited += lock_vectors_in_order(source_enum, samples, slots);
+            model.nickel_kiela_objective(source_enum, samples, lr);
+            release_vectors(slots);
+        } else {
+            if (!lock_drawn_vectors(source_enum, samples, slots, rejections)) {
+                // couldn't obtain one of the necessary locks, so skip!
+                skipped++;
+                continue;
+            }
+            model.nickel_kiela_objective(source_enum, samples, lr);
+            release_vectors(slots);
         }
-        model.nickel_kiela_objective(source_enum, samples, lr);
-        release_vectors(source_enum, samples);
         if (thread_id == 0) {
             // only thread 0 is responsible for printing progress info
             if (iter_count % REPORTING_INTERVAL == 0) {
@@ -124,7 +699,14 @@ void Poincare::epoch_thread(int32_t thread_id, uint32_t seed, real start_lr, rea
             }
         }
     }
-    performance += model.get_performance();
+    thread_performance_[thread_id] = model.get_performance();
+    thread_rejections_[thread_id] = rejections;
+    edges_trained_ += iter_count - skipped;
+    edges_skipped_ += skipped;
+    lock_wait_nanoseconds_ += waited;
+    sample_wait_nanoseconds_ += starved;
+    ring_occupancy_ += occupancy;
+    ring_pops_ += iter_count;
     if (thread_id == 0) {
         print_info(progress, lr);
         std::cerr << std::endl;
@@ -134,67 +716,302 @@ void Poincare::epoch_thread(int32_t thread_id, uint32_t seed, real start_lr, rea
     }
 }
 
-void Poincare::train() {
-    std::ifstream ifs(args_->graph);
-    if (!ifs.is_open()) {
-        throw std::invalid_argument(args_->graph + " cannot be opened!");
+template <typename T>
+void Poincare<T>::setup_partitions(const std::vector<int64_t>& counts) {
+    schedule_ = std::make_shared<PartitionSchedule>(*digraph, args_->partitions);
+    const int32_t partitions = schedule_->partitions();
+    partition_nodes_.assign(partitions, std::vector<node_t>());
+    for (node_t node = 0; node < digraph->node_count(); node++) {
+        partition_nodes_[schedule_->partition(node)].push_back(node);
+    }
+    // split the sampling table between the partitions by weight
+    partition_weights_.assign(partitions, 0.);
+    double total_weight = 0;
+    for (node_t node = 0; node < digraph->node_count(); node++) {
+        double weight = std::pow(counts[node], args_->distribution_power);
+        partition_weights_[schedule_->partition(node)] += weight;
+        total_weight += weight;
+    }
+    partition_samplers_.assign(partitions, nullptr);
+    for (int32_t p = 0; p < partitions; p++) {
+        if (partition_weights_[p] <= 0) {
+            continue;
+        }
+        std::vector<int64_t> partition_counts;
+        for (node_t node : partition_nodes_[p]) {
+            partition_counts.push_back(counts[node]);
+        }
+        partition_samplers_[p] = std::make_shared<Sampler>(args_->distribution_power, partition_counts, args_->threads);
+    }
+    std::cerr << "Scheduled " << schedule_->buckets().size() << " buckets of " << partitions
+              << " partitions in " << schedule_->rounds().size() << " rounds.\n";
+}
+
+template <typename T>
+void Poincare<T>::draw_partition_samples(node_t source, node_t target, const Bucket& bucket,
+                                         std::vector<node_t>& samples, Rng& rng, RejectionStats& stats) {
+    static const std::vector<node_t> nothing_excluded;
+    samples.clear();
+    samples.push_back(target);
+    const int32_t first = bucket.source_partition;
+    const int32_t second = bucket.target_partition;
+    // the chance of drawing from the first partition, rather than the second
+    double first_weight = partition_samplers_[first] ? partition_weights_[first] : 0;
+    double second_weight = (second != first && partition_samplers_[second]) ? partition_weights_[second] : 0;
+    if (first_weight + second_weight <= 0) {
+        truncate_samples(samples, samples.size(), stats);
+        return;
+    }
+    std::uniform_real_distribution<double> uniform(0, first_weight + second_weight);
+    int64_t rejections = 0; // in a row
+    for (int64_t attempts = int64_t(args_->max_negative_attempts) * args_->number_negatives;
+         int64_t(samples.size()) < args_->number_negatives + 1 && attempts > 0; attempts--) {
+        int32_t p = uniform(rng) < first_weight ? first : second;
+        node_t next_negative = partition_nodes_[p][partition_samplers_[p]->get_sample(nothing_excluded, rng)];
+        if (exclusions_->excludes(source, next_negative)) {
+            stats.rejections++;
+            stats.max_rejections = std::max(stats.max_rejections, ++rejections);
+            continue;
+        }
+        rejections = 0;
+        if (next_negative == source || std::find(samples.begin(), samples.end(), next_negative) != samples.end()) {
+            continue;
+        }
+        stats.samples++;
+        samples.push_back(next_negative);
+    }
+    truncate_samples(samples, samples.size(), stats);
+}
+
+template <typename T>
+void Poincare<T>::partitioned_epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                                           const std::vector<int32_t>& round_order, Barrier& barrier,
+                                           std::atomic<int64_t>* cursors, std::atomic<int64_t>& edges_started) {
+    Rng rng(seed);
+    const int64_t total_edges = digraph->edge_count();
+    const std::vector<Bucket>& buckets = schedule_->buckets();
+    const std::vector<std::vector<int32_t>>& rounds = schedule_->rounds();
+
+    int64_t iter_count = 0; // number processed so far
+    RejectionStats rejections;
+    T lr = start_lr;
+    T progress = 0.;
+    std::vector<node_t>& samples = thread_samples_[thread_id];
+    model.update_count = 1;
+    model.pullback_count = 0;
+    for (int32_t r : round_order) {
+        for (int64_t i = cursors[r]++; i < int64_t(rounds[r].size()); i = cursors[r]++) {
+            const Bucket& bucket = buckets[rounds[r][i]];
+            int64_t started = edges_started.fetch_add(bucket.edges.size());
+            for (int64_t j = 0; j < int64_t(bucket.edges.size()); j++) {
+                iter_count++;
+                node_t source_enum = digraph->edge_sources[bucket.edges[j]];
+                node_t target_enum = digraph->edge_targets[bucket.edges[j]];
+                progress = T(started + j) / total_edges;
+                lr = start_lr * (1.0 - progress) + end_lr * progress;
+                draw_partition_samples(source_enum, target_enum, bucket, samples, rng, rejections);
+                model.nickel_kiela_objective(source_enum, samples, lr);
+                if (thread_id == 0 && iter_count % REPORTING_INTERVAL == 0) {
+                    // only thread 0 is responsible for printing progress info
+                    print_info(progress, lr);
+                }
+            }
+        }
+        barrier.wait();
+    }
+    thread_performance_[thread_id] = model.get_performance();
+    thread_rejections_[thread_id] = rejections;
+    edges_trained_ += iter_count;
+    if (thread_id == 0) {
+        print_info(progress, lr);
+        std::cerr << std::endl;
+        std::cerr << std::setfill('0');
+        std::cerr << "Thread 0: trained " << std::setw(6) << iter_count << " problems; ";
+        std::cerr << "pullbacks for " << std::setw(6) << model.pullback_count << "/" << std::setw(6) << model.update_count << " updates.\n";
+    }
+}
+
+template <typename T>
+void Poincare<T>::train() {
+    if (args_->graph_cache.empty()) {
+        digraph = std::make_shared<Digraph>(args_->graph, args_->threads);
+    } else {
+        digraph = std::make_shared<Digraph>(args_->graph, args_->threads, args_->graph_cache);
+    }
+    if (args_->relabel != RelabelMode::NONE) {
+        // before anything is indexed by node
+        if (args_->relabel == RelabelMode::BREADTH_FIRST) {
+            digraph->relabel(breadth_first_order(*digraph));
+        } else if (args_->relabel == RelabelMode::DEPTH_FIRST) {
+            digraph->relabel(depth_first_order(*digraph));
+        } else {
+            digraph->relabel(degree_order(*digraph));
+        }
+        std::cerr << "Relabelled the nodes in " << Args::relabel_name(args_->relabel) << " order.\n";
     }
-    digraph = std::make_shared<Digraph>(ifs);
-    ifs.close();
     
     // setup the negative sampler
-    std::vector<int64_t> counts(digraph->node_count());
-    for (int i=0; i < digraph->node_count(); i++) {
-        counts[i] = (digraph->enumeration2node)[i]->count_as_target;
-    }
+    const std::vector<int64_t>& counts = digraph->count_as_target;
+    exclusions_ = std::make_shared<ExclusionIndex>(*digraph, EXCLUSION_FILTER_DEGREE);
+    std::cerr << "Excluding the targets of each node from its negatives (" << exclusions_->bytes() << " bytes, "
+              << exclusions_->filtered_nodes() << " nodes filtered).\n";
     std::cerr << "Generating negative samples...\n";
-    sampler = std::make_shared<Sampler>(args_->distribution_power, counts, NEGATIVE_TABLE_SIZE);
+    if (args_->partitions > 0) {
+        setup_partitions(counts);
+    } else {
+        sampler = std::make_shared<Sampler>(args_->distribution_power, counts, args_->threads);
+    }
     // initialise the vectors
+    std::cerr << "Using " << isa_name(kernels<T>().isa) << " vector kernels.\n";
     std::minstd_rand rng(args_->seed);
-    Vector init_vector(args_->dimension + 1);
-    vectors_ = std::make_shared<std::vector<Vector>>();
+    vectors_ = std::make_shared<Matrix<T>>(digraph->node_count(), args_->dimension + 1, args_->huge_pages);
     for (int64_t i=0; i < digraph->node_count(); i++) {
+        Vector<T> init_vector(vectors_->row(i), vectors_->cols());
         random_hyperboloid_point(init_vector, rng, args_->init_std_dev);
-        vectors_->push_back(init_vector);
+        if (args_->lock_free) {
+            init_vector.to_ball_point();
+        }
     }
     // overwrite the init vectors with any pre-trained vectors
     if (!(args_->input_vectors).empty()) {
         std::cerr << "Loading vectors: " << args_->input_vectors << "\n";
         load_vectors(args_->input_vectors);
     }
-    vector_flags_ = std::shared_ptr<std::vector<std::mutex>>(new std::vector<std::mutex>(vectors_->size()));
+    if (!args_->lock_free && args_->partitions == 0) {
+        locks_ = std::make_shared<LockTable>(vectors_->size(), args_->lock_table, args_->lock_stripes);
+        std::cerr << "Using a " << Args::lock_table_name(args_->lock_table) << " lock table of "
+                  << locks_->bytes() << " bytes.\n";
+    }
+    // start the worker threads, each with the specialised model for our
+    // dimension and number of negatives, if there is one, and any sampler
+    // threads (numbered after the workers); these are reused for every epoch
+    ThreadPool pool(args_->threads + args_->sampler_threads);
+    std::vector<std::shared_ptr<Model<T>>> models;
+    for (int32_t thread_id = 0; thread_id < args_->threads; thread_id++) {
+        models.push_back(create_model(vectors_, args_));
+    }
+    thread_performance_.assign(args_->threads, 0);
+    thread_rejections_.assign(args_->threads, RejectionStats());
+    thread_samples_.assign(args_->threads, std::vector<node_t>());
+    thread_slots_.assign(args_->threads, std::vector<int64_t>());
+    for (int32_t thread_id = 0; thread_id < args_->threads; thread_id++) {
+        thread_samples_[thread_id].reserve(args_->number_negatives + 1);
+        thread_slots_[thread_id].reserve(args_->number_negatives + 2);
+    }
+    if (args_->sampler_threads > 0) {
+        for (int32_t thread_id = 0; thread_id < args_->threads; thread_id++) {
+            rings_.emplace_back(new SampleRing(RING_CAPACITY, args_->number_negatives));
+        }
+        sampler_rejections_.assign(args_->sampler_threads, RejectionStats());
+    }
+    // grouped training claims sources, and otherwise edges
+    WorkQueues queues(args_->threads, args_->group_by_source ? digraph->node_count() : digraph->edge_count(),
+                      args_->group_by_source ? SOURCE_CHUNK : EDGE_CHUNK);
+    // for partitioned training
+    Barrier barrier(args_->threads);
+    std::vector<int32_t> round_order;
+    std::unique_ptr<std::atomic<int64_t>[]> cursors;
+    if (schedule_) {
+        cursors.reset(new std::atomic<int64_t>[schedule_->rounds().size()]);
+    }
+    Rng shuffle_rng(args_->seed);
     // start the training!
-    real lr_delta_per_epoch = (args_->start_lr - args_->end_lr) / args_->epochs;;
+    T lr_delta_per_epoch = (args_->start_lr - args_->end_lr) / args_->epochs;;
     for (int32_t epoch = 0; epoch < args_->epochs; epoch++) {
         save_checkpoint(epoch, performance);
         std::cerr << "\n" << std::string(80, '-') << "\n\n";
         std::cerr << "\rEpoch: " << (epoch + 1) << " / " << args_->epochs;
         std::cerr << std::flush;
-        real epoch_start_lr = args_->start_lr - real(epoch) * lr_delta_per_epoch;
-        real epoch_end_lr = args_->start_lr - real(epoch + 1) * lr_delta_per_epoch;
-        std::vector<std::thread> threads;
-        performance = 0;
+        T epoch_start_lr = args_->start_lr - T(epoch) * lr_delta_per_epoch;
+        T epoch_end_lr = args_->start_lr - T(epoch + 1) * lr_delta_per_epoch;
+        edges_trained_ = 0;
+        edges_skipped_ = 0;
+        lock_wait_nanoseconds_ = 0;
+        sample_wait_nanoseconds_ = 0;
+        room_wait_nanoseconds_ = 0;
+        ring_occupancy_ = 0;
+        ring_pops_ = 0;
         clock_t start = clock();
-        for (int32_t thread_id = 0; thread_id < args_->threads; thread_id++) {
+        auto wall_start = std::chrono::steady_clock::now();
+        std::atomic<int64_t> edges_started(0);
+        queues.reset();
+        if (schedule_) {
+            const int64_t rounds = schedule_->rounds().size();
+            // visit the rounds in a different order each epoch
+            round_order.clear();
+            for (int32_t r = 0; r < rounds; r++) {
+                round_order.push_back(r);
+                cursors[r] = 0;
+            }
+            std::minstd_rand order_rng(1 + args_->seed + epoch);
+            std::shuffle(round_order.begin(), round_order.end(), order_rng);
+        } else if (args_->shuffle != ShuffleMode::NONE) {
+            const int64_t block = args_->shuffle == ShuffleMode::FULL ? digraph->edge_count() : args_->shuffle_block;
+            blocked_shuffle(digraph->edge_count(), std::max<int64_t>(block, 1), shuffle_rng, edge_order_);
+        }
+        pool.run([&](int32_t thread_id) {
             int32_t thread_seed = args_->seed + epoch * args_->threads + thread_id;
-            threads.push_back(std::thread([=]() {
-                epoch_thread(thread_id, thread_seed, epoch_start_lr, epoch_end_lr);
-            }));
+            if (thread_id >= args_->threads) {
+                sampler_thread(thread_id - args_->threads, thread_seed, queues, edges_started);
+            } else if (args_->sampler_threads > 0) {
+                pipelined_epoch_thread(thread_id, epoch_start_lr, epoch_end_lr, *models[thread_id]);
+            } else if (schedule_) {
+                partitioned_epoch_thread(thread_id, thread_seed, epoch_start_lr, epoch_end_lr, *models[thread_id],
+                                         round_order, barrier, cursors.get(), edges_started);
+            } else if (args_->batch_size > 0) {
+                batch_epoch_thread(thread_id, thread_seed, epoch_start_lr, epoch_end_lr, *models[thread_id],
+                                   queues, edges_started);
+            } else if (args_->group_by_source) {
+                grouped_epoch_thread(thread_id, thread_seed, epoch_start_lr, epoch_end_lr, *models[thread_id],
+                                     queues, edges_started);
+            } else {
+                epoch_thread(thread_id, thread_seed, epoch_start_lr, epoch_end_lr, *models[thread_id],
+                             queues, edges_started);
+            }
+        });
+        performance = 0;
+        RejectionStats rejections;
+        for (int32_t thread_id = 0; thread_id < args_->threads; thread_id++) {
+            performance += thread_performance_[thread_id];
+            rejections.add(thread_rejections_[thread_id]);
         }
-        for (auto it = threads.begin(); it != threads.end(); ++it) {
-            it->join();
+        for (const RejectionStats& sampler_rejections : sampler_rejections_) {
+            rejections.add(sampler_rejections);
         }
         performance /= args_->threads;
-        real cpu_time_single_thread = real(clock() - start) / (CLOCKS_PER_SEC * args_->threads);
+        T cpu_time_single_thread = T(clock() - start) / (CLOCKS_PER_SEC * pool.size());
+        double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        int64_t edges_considered = edges_trained_ + edges_skipped_;
         std::cerr << std::setfill(' ');
         std::cerr << "Epoch took " << std::setw(5) << std::setprecision(3) << cpu_time_single_thread << " seconds; ";
         std::cerr << "mean objective " << std::setw(5) << std::setprecision(3) << performance << "\n";
+        std::cerr << "Trained " << int64_t(edges_trained_ / wall_time) << " edges per second; ";
+        std::cerr << "skipped " << edges_skipped_ << "/" << edges_considered << " edges ("
+                  << std::setprecision(3) << 100. * edges_skipped_ / std::max<int64_t>(edges_considered, 1) << "%)";
+        if (args_->ordered_locking || (args_->group_by_source && locks_)) {
+            std::cerr << "; waited " << std::setprecision(3) << lock_wait_nanoseconds_ * 1e-9 << " seconds for locks";
+        }
+        std::cerr << "\n";
+        std::cerr << "Rejected " << rejections.rejections << " draws of targets for "
+                  << rejections.samples << " negative samples (at most " << rejections.max_rejections << " in a row)";
+        if (locks_ && !args_->ordered_locking) {
+            std::cerr << "; " << rejections.lock_failures << " were locked";
+        }
+        std::cerr << "; " << rejections.shortfalls << " edges trained with "
+                  << rejections.missing << " negatives missing\n";
+        if (args_->sampler_threads > 0) {
+            std::cerr << "Training threads waited " << std::setprecision(3) << sample_wait_nanoseconds_ * 1e-9
+                      << " seconds for edges, sampler threads " << room_wait_nanoseconds_ * 1e-9
+                      << " seconds for room; rings " << 100. * ring_occupancy_ / (std::max<int64_t>(ring_pops_, 1) * RING_CAPACITY)
+                      << "% full on average\n";
+        }
         std::cerr << std::flush;
     }
     save_checkpoint(args_->epochs, performance);
 }
 
-void Poincare::save_checkpoint(int32_t epochs_trained, real performance) {
+template <typename T>
+void Poincare<T>::save_checkpoint(int32_t epochs_trained, T performance) {
     if (args_->checkpoint_interval > 0 && epochs_trained % args_->checkpoint_interval == 0) {
         // checkpoint (save) the vectors - pad epoch number to maintain
         // alphabetical ordering
@@ -208,4 +1025,8 @@ void Poincare::save_checkpoint(int32_t epochs_trained, real performance) {
     }
 }
 
+template class Poincare<float>;
+template class Poincare<double>;
+template class Poincare<long double>;
+
 }
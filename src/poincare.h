@@ -1,47 +1,177 @@
 #pragma once
 
+#include <atomic>
 #include <random>
 #include <fstream>
 #include <memory>
 
 #include "args.h"
+#include "barrier.h"
 #include "digraph.h"
+#include "exclusion.h"
+#include "locks.h"
 #include "sampler.h"
+#include "shuffle.h"
+#include "matrix.h"
 #include "model.h"
-#include "real.h"
+#include "partitions.h"
+#include "random.h"
+#include "relabel.h"
+#include "ring.h"
+#include "thread_pool.h"
 #include "vector.h"
 
 namespace poincare {
 
-static const int32_t NEGATIVE_TABLE_SIZE = 100000000; // increased from the original
-
+template <typename T>
 class Poincare {
+    /**
+     * Trains the embedding, with all vectors and calculations at scalar
+     * precision `T`.
+     */
+
  protected:
     std::shared_ptr<Args> args_;
     std::shared_ptr<Digraph> digraph;
     std::shared_ptr<Sampler> sampler;
+    // the targets of each node, which are not drawn as its negatives
+    std::shared_ptr<ExclusionIndex> exclusions_;
+
+    std::shared_ptr<Matrix<T>> vectors_;
+    std::shared_ptr<LockTable> locks_;
+
+    // for partitioned training: the schedule, and for each partition, its
+    // nodes, a sampler of these (nullptr if none can be sampled) and the
+    // total weight of the sampling distribution on them
+    std::shared_ptr<PartitionSchedule> schedule_;
+    std::vector<std::vector<node_t>> partition_nodes_;
+    std::vector<std::shared_ptr<Sampler>> partition_samplers_;
+    std::vector<double> partition_weights_;
+
+    // with sampler threads: per training thread, the queue of its edges with
+    // their negatives; per sampler thread, its negative samples drawn
+    // during the current epoch
+    std::vector<std::unique_ptr<SampleRing>> rings_;
+    std::vector<RejectionStats> sampler_rejections_;
 
-    std::shared_ptr<std::vector<Vector>> vectors_;
-    std::shared_ptr<std::vector<std::mutex>> vector_flags_;
+    // the edges in the order to train them in the current epoch (empty for
+    // the order of the training file), see Args::shuffle
+    std::vector<int64_t> edge_order_;
 
-    std::shared_ptr<Model> model_;
-    real performance;
+    T performance;
+    // per thread: the performance of its model over the current epoch, and
+    // its buffers for the samples of an edge and the slots of their locks
+    std::vector<T> thread_performance_;
+    std::vector<std::vector<node_t>> thread_samples_;
+    std::vector<std::vector<int64_t>> thread_slots_;
+    // per thread: its negative samples drawn during the current epoch
+    std::vector<RejectionStats> thread_rejections_;
 
-    void save_checkpoint(int32_t epochs_trained, real performance);
+    // over all threads, the number of edges trained and skipped (due to
+    // locking) during the current epoch
+    std::atomic<int64_t> edges_trained_;
+    std::atomic<int64_t> edges_skipped_;
+    // over all threads, the time spent waiting for locks during the current
+    // epoch (only for ordered locking, and for the sources of grouped
+    // training)
+    std::atomic<int64_t> lock_wait_nanoseconds_;
+    // with sampler threads, over the current epoch: the time the training
+    // threads spent waiting for edges and the sampler threads for room in
+    // the queues, and the sum of the number of entries in the queues after
+    // each edge is taken from them (and the number of edges taken)
+    std::atomic<int64_t> sample_wait_nanoseconds_;
+    std::atomic<int64_t> room_wait_nanoseconds_;
+    std::atomic<int64_t> ring_occupancy_;
+    std::atomic<int64_t> ring_pops_;
+
+    void save_checkpoint(int32_t epochs_trained, T performance);
 
     /**
      * Lock both the source and target; if this fails, return false; if it
      * succeeds, then proceed to lock the specified number of negative samples,
      * which are guaranteed to be distinct, and return true, in which case the
      * vector `samples` is populated with target, and then the negative samples.
-     * If false is returned, then `samples` is unchanged.
+     * Negatives whose locks are held by other threads are discarded (without
+     * waiting); after args_->max_negative_attempts draws per negative
+     * required, the edge is trained with the negatives locked so far.
+     * The slots of the locks held are recorded in `slots` (a slot shared by
+     * several of the vectors is locked once).    If false is returned, then
+     * `samples` is unchanged and no locks are held beyond those already in
+     * `slots` on entry (such as that of the source, when training a group
+     * of edges from it).    The negatives drawn,
+     * those rejected as targets of the source or as locked, and any shortfall
+     * are counted in `stats`.
+     */
+    bool obtain_vectors(node_t source, node_t target, std::vector<node_t>& samples,
+                        std::vector<int64_t>& slots, Rng& rng, RejectionStats& stats);
+
+    /**
+     * As for obtain_vectors, for `samples` already drawn (the target, then
+     * the negatives): lock the source and target, or return false, holding
+     * no locks; then lock the negatives, discarding from `samples` those
+     * whose locks are held by other threads.
+     */
+    bool lock_drawn_vectors(node_t source, std::vector<node_t>& samples, std::vector<int64_t>& slots,
+                            RejectionStats& stats);
+
+    /**
+     * Lock the slot of the node, unless it is among `slots` (already held),
+     * recording it there; return whether the slot is now held.
      */
-    bool obtain_vectors(int32_t source, int32_t target, std::vector<int32_t>& samples, std::minstd_rand& rng);
+    bool lock_vector(node_t node, std::vector<int64_t>& slots);
 
     /**
-     * Release the locks of source and all the samples provided.
+     * For ordered locking: lock the slots of the source and all the samples
+     * (which should be distinct), in increasing order of slot, waiting for
+     * each as necessary; since every thread locks in the same order, this can
+     * not deadlock.    The slots locked are recorded in `slots`.    Return the
+     * time spent waiting, in nanoseconds.
      */
-    void release_vectors(int32_t source, std::vector<int32_t>& samples);
+    int64_t lock_vectors_in_order(node_t source, std::vector<node_t>& samples, std::vector<int64_t>& slots);
+
+    /**
+     * Lock the slots provided, in increasing order, waiting for each as
+     * necessary (see lock_vectors_in_order), after removing any repeats.
+     * Return the time spent waiting, in nanoseconds.
+     */
+    int64_t lock_slots_in_order(std::vector<int64_t>& slots);
+
+    /**
+     * Lock the slot, spinning and then yielding until it is free; return the
+     * time spent waiting, in nanoseconds.
+     */
+    int64_t wait_for_lock(int64_t slot);
+
+    /**
+     * Release the locks of the slots provided, except for the first `keep`,
+     * and remove them from `slots`.
+     */
+    void release_vectors(std::vector<int64_t>& slots, size_t keep = 0);
+
+    /**
+     * As for obtain_vectors, but without locking anything (for lock-free
+     * training, or before ordered locking): populate `samples` with target,
+     * then negative samples distinct from one another and from the source.
+     */
+    void draw_samples(node_t source, node_t target, std::vector<node_t>& samples, Rng& rng,
+                      RejectionStats& stats);
+
+    /**
+     * For mini-batch training: draw args_->number_negatives distinct
+     * negatives into `negatives`, to be shared by the edges of a batch (so
+     * without regard to any source; see batch_epoch_thread), giving up after
+     * args_->max_negative_attempts draws per negative.    If `slots` is not
+     * nullptr, also lock each negative, discarding those whose locks are
+     * held by other threads, and record the slots locked there.
+     */
+    void draw_shared_negatives(std::vector<node_t>& negatives, std::vector<int64_t>* slots, Rng& rng,
+                               RejectionStats& stats);
+
+    /**
+     * Keep the first `filled` of `samples` (the target and the negatives
+     * acquired), counting in `stats` if these are fewer than required.
+     */
+    void truncate_samples(std::vector<node_t>& samples, int32_t filled, RejectionStats& stats);
 
  public:
     Poincare(std::shared_ptr<Args> args);
@@ -56,12 +186,84 @@ class Poincare {
      * Given the filename of a CSV containing the vectors for
      * each node (as points on the Poincaré ball), load these
      * as model parameters, converting them to points on the
-     * hyperboloid.
+     * hyperboloid (unless training lock-free, when the
+     * parameters are points on the ball).
      */
     void load_vectors(std::string);
-    void print_info(real, real);
+    void print_info(T, T);
+
+    /**
+     * Train one epoch, as one of args_->threads threads: train the chunks of
+     * edges claimed from `queues` (first those of this thread, then any left
+     * by the others).    `edges_started` counts the edges claimed so far, by
+     * all threads, and gives the progress of the epoch.
+     */
+    void epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                      WorkQueues& queues, std::atomic<int64_t>& edges_started);
 
-    void epoch_thread(int32_t thread_id, uint32_t seed, real start_lr, real end_lr);
+    /**
+     * As for epoch_thread, but claiming chunks of sources from `queues`,
+     * and training all the edges from each source as a group (see
+     * Model::begin_group), holding the lock of the source throughout; the
+     * thread waits for the lock of the source (while holding no others), but
+     * skips the edges whose other locks are held.
+     */
+    void grouped_epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                              WorkQueues& queues, std::atomic<int64_t>& edges_started);
+
+    /**
+     * As for epoch_thread, but training the edges in mini-batches of
+     * args_->batch_size (see Model::batch_objective), each sharing one
+     * draw of negatives, of which those that are the source or a target of
+     * the source of an edge are excluded for that edge.    With locking,
+     * the edges whose source or target can not be locked are skipped, and
+     * then the negatives locked as drawn; with ordered locking, the locks of
+     * the whole batch are acquired in order.
+     */
+    void batch_epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                            WorkQueues& queues, std::atomic<int64_t>& edges_started);
+
+    /**
+     * With sampler threads: as one of args_->sampler_threads threads, draw
+     * the negatives for the edges of the training threads it serves (those
+     * numbered sampler_id modulo args_->sampler_threads), claiming chunks of
+     * edges from `queues` on their behalf, and append them to their rings
+     * (waiting while these are full); then append a last entry of position
+     * -1 to each ring, to mark the end of the epoch.
+     */
+    void sampler_thread(int32_t sampler_id, uint32_t seed, WorkQueues& queues, std::atomic<int64_t>& edges_started);
+
+    /**
+     * As for epoch_thread, but training the edges taken from the ring of this
+     * thread, with the negatives already drawn by a sampler thread, until
+     * the end of the epoch is reached.    With locking, negatives whose locks
+     * are held are discarded without replacement.
+     */
+    void pipelined_epoch_thread(int32_t thread_id, T start_lr, T end_lr, Model<T>& model);
+
+    /**
+     * Build the partition schedule and the per-partition samplers for
+     * partitioned training, for the given (unnormalised) counts.
+     */
+    void setup_partitions(const std::vector<int64_t>& counts);
+
+    /**
+     * As for draw_samples, but drawing the negatives from the partitions of
+     * `bucket` only (so possibly fewer of them, if these have too few nodes).
+     */
+    void draw_partition_samples(node_t source, node_t target, const Bucket& bucket,
+                                std::vector<node_t>& samples, Rng& rng, RejectionStats& stats);
+
+    /**
+     * Train one epoch of partitioned training, as one of args_->threads
+     * threads: for each round of the schedule, in the order `round_order`,
+     * train the buckets of the round claimed from `cursors` (one per round),
+     * then wait at `barrier` for the other threads.    `edges_started` counts the edges of the buckets
+     * claimed so far, by all threads, and gives the progress of the epoch.
+     */
+    void partitioned_epoch_thread(int32_t thread_id, uint32_t seed, T start_lr, T end_lr, Model<T>& model,
+                                  const std::vector<int32_t>& round_order, Barrier& barrier,
+                                  std::atomic<int64_t>* cursors, std::atomic<int64_t>& edges_started);
     void train();
 
 };
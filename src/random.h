@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace poincare {
+
+class Rng {
+    /**
+     * The xoshiro256** generator of Blackman & Vigna: 64-bit output, a period
+     * of 2^256 - 1 and a few cycles per number.    It is a uniform random bit
+     * generator, so may be used with the distributions and algorithms of the
+     * standard library.    Numbers in a range are obtained without division
+     * or bias by bounded() (after Lemire, "Fast random integer generation in
+     * an interval").
+     */
+
+    public:
+        typedef uint64_t result_type;
+
+        /**
+         * Any seed (including 0) is fine: the state is initialised from it by
+         * splitmix64.
+         */
+        explicit Rng(uint64_t seed) {
+            for (int i = 0; i < 4; i++) {
+                seed += 0x9e3779b97f4a7c15;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                s_[i] = z ^ (z >> 31);
+            }
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        result_type operator()() {
+            const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+            const uint64_t t = s_[1] << 17;
+            s_[2] ^= s_[0];
+            s_[3] ^= s_[1];
+            s_[1] ^= s_[2];
+            s_[0] ^= s_[3];
+            s_[2] ^= t;
+            s_[3] = rotl(s_[3], 45);
+            return result;
+        }
+
+        /**
+         * Return a uniform random number in [0, range), for range > 0.
+         */
+        uint32_t bounded(uint32_t range) {
+            return bounded(range, uint32_t((*this)() >> 32));
+        }
+
+        /**
+         * As bounded(range), given 32 random bits to begin with (drawing
+         * more only in the rare case, of probability below range / 2^32, that
+         * these do not suffice).
+         */
+        uint32_t bounded(uint32_t range, uint32_t bits) {
+            uint64_t product = uint64_t(bits) * range;
+            if (uint32_t(product) < range) {
+                const uint32_t threshold = -range % range;
+                while (uint32_t(product) < threshold) {
+                    product = ((*this)() >> 32) * range;
+                }
+            }
+            return product >> 32;
+        }
+
+        /**
+         * As bounded(range), for any range > 0 of 64 bits.
+         */
+        uint64_t bounded64(uint64_t range) {
+            unsigned __int128 product = (unsigned __int128)(*this)() * range;
+            if (uint64_t(product) < range) {
+                const uint64_t threshold = -range % range;
+                while (uint64_t(product) < threshold) {
+                    product = (unsigned __int128)(*this)() * range;
+                }
+            }
+            return product >> 64;
+        }
+
+    protected:
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        uint64_t s_[4];
+};
+
+}
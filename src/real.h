@@ -1,3 +1,6 @@
 #pragma once
 
+// The highest available precision.    The training pipeline is templated on its
+// scalar type (see Args::precision); this is the default, and the reference
+// against which the lower precisions are compared.
 typedef long double real;
@@ -0,0 +1,144 @@
+#include "relabel.h"
+
+#include <algorithm>
+
+namespace poincare {
+
+namespace {
+
+/**
+ * The spanning forest of the hierarchy (see relabel.h): the roots, and the
+ * children of each node (those of node n are children[offsets[n]], ...,
+ * children[offsets[n + 1] - 1]), in the order of their enumeration.
+ */
+struct Forest {
+    std::vector<node_t> roots;
+    std::vector<int64_t> offsets;
+    std::vector<node_t> children;
+};
+
+Forest spanning_forest(const Digraph& digraph) {
+    const int64_t nodes = digraph.node_count();
+    std::vector<node_t> parents(nodes, -1);
+    Forest forest;
+    forest.offsets.assign(nodes + 1, 0);
+    for (node_t n = 0; n < nodes; n++) {
+        // the deepest target, the first of these if there are several
+        for (int64_t i = digraph.target_offsets[n]; i < digraph.target_offsets[n + 1]; i++) {
+            const node_t target = digraph.target_enums[i];
+            const node_t parent = parents[n];
+            if (target == n) {
+                continue;
+            }
+            const int64_t depth = digraph.count_as_source[target];
+            if (parent < 0 || depth > digraph.count_as_source[parent]
+                    || (depth == digraph.count_as_source[parent] && target < parent)) {
+                parents[n] = target;
+            }
+        }
+        if (parents[n] < 0) {
+            forest.roots.push_back(n);
+        } else {
+            forest.offsets[parents[n] + 1]++;
+        }
+    }
+    // a counting sort of the nodes by parent
+    for (int64_t n = 0; n < nodes; n++) {
+        forest.offsets[n + 1] += forest.offsets[n];
+    }
+    std::vector<int64_t> cursors(forest.offsets.begin(), forest.offsets.end() - 1);
+    forest.children.resize(nodes - forest.roots.size());
+    for (node_t n = 0; n < nodes; n++) {
+        if (parents[n] >= 0) {
+            forest.children[cursors[parents[n]]++] = n;
+        }
+    }
+    return forest;
+}
+
+/**
+ * Append to `order` the nodes not yet visited of the subtree of `start`,
+ * breadth first, marking them visited.
+ */
+void visit_breadth_first(const Forest& forest, node_t start, std::vector<bool>& visited, std::vector<node_t>& order) {
+    if (visited[start]) {
+        return;
+    }
+    visited[start] = true;
+    int64_t next = order.size();
+    order.push_back(start);
+    for (; next < int64_t(order.size()); next++) {
+        const node_t n = order[next];
+        for (int64_t i = forest.offsets[n]; i < forest.offsets[n + 1]; i++) {
+            const node_t child = forest.children[i];
+            if (!visited[child]) {
+                visited[child] = true;
+                order.push_back(child);
+            }
+        }
+    }
+}
+
+/**
+ * As visit_breadth_first, depth first.
+ */
+void visit_depth_first(const Forest& forest, node_t start, std::vector<bool>& visited, std::vector<node_t>& order) {
+    // the nodes still to visit, the next on top (so children are pushed in
+    // reverse)
+    std::vector<node_t> stack(1, start);
+    while (!stack.empty()) {
+        const node_t n = stack.back();
+        stack.pop_back();
+        if (visited[n]) {
+            continue;
+        }
+        visited[n] = true;
+        order.push_back(n);
+        for (int64_t i = forest.offsets[n + 1] - 1; i >= forest.offsets[n]; i--) {
+            stack.push_back(forest.children[i]);
+        }
+    }
+}
+
+/**
+ * Visit the whole forest with `visit`: from the roots, then from any node not
+ * reached from them (one on, or below, a cycle of parents).
+ */
+template <typename Visit>
+std::vector<node_t> forest_order(const Digraph& digraph, Visit visit) {
+    const Forest forest = spanning_forest(digraph);
+    std::vector<node_t> order;
+    order.reserve(digraph.node_count());
+    std::vector<bool> visited(digraph.node_count(), false);
+    for (node_t root : forest.roots) {
+        visit(forest, root, visited, order);
+    }
+    for (node_t n = 0; n < digraph.node_count(); n++) {
+        visit(forest, n, visited, order);
+    }
+    return order;
+}
+
+}
+
+std::vector<node_t> breadth_first_order(const Digraph& digraph) {
+    return forest_order(digraph, visit_breadth_first);
+}
+
+std::vector<node_t> depth_first_order(const Digraph& digraph) {
+    return forest_order(digraph, visit_depth_first);
+}
+
+std::vector<node_t> degree_order(const Digraph& digraph) {
+    std::vector<node_t> order(digraph.node_count());
+    for (node_t n = 0; n < digraph.node_count(); n++) {
+        order[n] = n;
+    }
+    std::stable_sort(order.begin(), order.end(), [&digraph](node_t a, node_t b) {
+        return digraph.count_as_source[a] + digraph.count_as_target[a]
+            > digraph.count_as_source[b] + digraph.count_as_target[b];
+    });
+    return order;
+}
+
+}
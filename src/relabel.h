@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "digraph.h"
+#include "node.h"
+
+namespace poincare {
+
+/**
+ * Orders of the nodes of a graph that place related nodes near one another,
+ * for Digraph::relabel.    Each returns a permutation of the nodes: the nodes
+ * in their new order.
+ *
+ * The hierarchy orders regard each edge as pointing from a node to one of its
+ * ancestors, and take as the parent of a node its deepest ancestor, meaning
+ * that with the most edges of its own (so that in a transitive closure, the
+ * parent is the immediate ancestor).    The roots are the nodes without
+ * edges.    Roots, and the children of each node, are taken in the order of
+ * their enumeration.
+ */
+
+/**
+ * The nodes of the hierarchy breadth first: the roots, then their children,
+ * then their grandchildren, ...
+ */
+std::vector<node_t> breadth_first_order(const Digraph& digraph);
+
+/**
+ * The nodes of the hierarchy depth first, each followed by its subtree (so
+ * that every subtree is contiguous).
+ */
+std::vector<node_t> depth_first_order(const Digraph& digraph);
+
+/**
+ * The nodes by decreasing number of edges (from and to the node), so that
+ * the nodes most often trained are together.
+ */
+std::vector<node_t> degree_order(const Digraph& digraph);
+
+}
@@ -0,0 +1,72 @@
+#include "ring.h"
+
+#include <algorithm>
+
+namespace poincare {
+
+namespace {
+
+int64_t round_up_to_power_of_two(int64_t n) {
+    int64_t power = 1;
+    while (power < n) {
+        power *= 2;
+    }
+    return power;
+}
+
+}
+
+SampleRing::SampleRing(int64_t capacity, int32_t max_negatives) :
+        mask_(round_up_to_power_of_two(std::max<int64_t>(capacity, 1)) - 1),
+        max_negatives_(max_negatives),
+        entries_(mask_ + 1),
+        negatives_((mask_ + 1) * max_negatives),
+        head_(0),
+        cached_tail_(0),
+        tail_(0),
+        cached_head_(0) {}
+
+bool SampleRing::try_push(int64_t position, node_t source, node_t target, const node_t* negatives, int32_t count) {
+    const int64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ > mask_) {
+            return false;
+        }
+    }
+    const int64_t index = tail & mask_;
+    Entry& entry = entries_[index];
+    entry.position = position;
+    entry.source = source;
+    entry.target = target;
+    entry.count = count;
+    std::copy(negatives, negatives + count, negatives_.data() + index * max_negatives_);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool SampleRing::try_pop(int64_t& position, node_t& source, node_t& target, node_t* negatives, int32_t& count) {
+    const int64_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head == cached_tail_) {
+            return false;
+        }
+    }
+    const int64_t index = head & mask_;
+    const Entry& entry = entries_[index];
+    position = entry.position;
+    source = entry.source;
+    target = entry.target;
+    count = entry.count;
+    const node_t* first = negatives_.data() + index * max_negatives_;
+    std::copy(first, first + count, negatives);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+int64_t SampleRing::size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+}
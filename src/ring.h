@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "node.h"
+
+namespace poincare {
+
+class SampleRing {
+    /**
+     * A bounded queue of edges with their negative samples, passed from one
+     * producer thread (which draws the negatives) to one consumer thread
+     * (which trains the edges), without locks: the producer only ever
+     * advances the tail, and the consumer the head, each publishing the
+     * entries before it with a release store.    The two indices are kept on
+     * separate cache lines, and each side remembers the last value it read
+     * of the other's, so that the shared lines are only read again when the
+     * queue appears full (or empty).
+     */
+
+    public:
+        /**
+         * A queue of `capacity` (rounded up to a power of two) entries, each
+         * with room for up to `max_negatives` negatives.
+         */
+        SampleRing(int64_t capacity, int32_t max_negatives);
+
+        SampleRing(const SampleRing&) = delete;
+        SampleRing& operator=(const SampleRing&) = delete;
+
+        int64_t capacity() const { return mask_ + 1; }
+
+        /**
+         * Producer: append the entry, unless the queue is full, returning
+         * whether it was appended.    `position` is any number the consumer is
+         * to receive with the edge (e.g. its position in the epoch); `count`
+         * must not exceed `max_negatives`.
+         */
+        bool try_push(int64_t position, node_t source, node_t target, const node_t* negatives, int32_t count);
+
+        /**
+         * Consumer: remove the oldest entry into the arguments (with room for
+         * `max_negatives` in `negatives`), unless the queue is empty,
+         * returning whether there was one.
+         */
+        bool try_pop(int64_t& position, node_t& source, node_t& target, node_t* negatives, int32_t& count);
+
+        /**
+         * Return the number of entries in the queue (exact only when called
+         * by the producer or consumer while the other is idle).
+         */
+        int64_t size() const;
+
+    protected:
+        struct Entry {
+            int64_t position;
+            node_t source;
+            node_t target;
+            int32_t count;
+        };
+
+        const int64_t mask_;
+        const int32_t max_negatives_;
+        std::vector<Entry> entries_;
+        // the negatives of entry i are negatives_[i * max_negatives_], ...
+        std::vector<node_t> negatives_;
+
+        // padding keeps the indices of the two sides on separate cache lines
+        // (and off the lines of the fields above)
+        char padding0_[64];
+        // the consumer's side: the next entry to read, and the tail as last seen
+        std::atomic<int64_t> head_;
+        int64_t cached_tail_;
+        char padding1_[64];
+        // the producer's side: the next entry to write, and the head as last seen
+        std::atomic<int64_t> tail_;
+        int64_t cached_head_;
+        char padding2_[64];
+};
+
+}
@@ -1,26 +1,128 @@
 #include "sampler.h"
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+// the number of samples drawn at a time by Sampler::sample_batch
+constexpr int32_t SAMPLE_BLOCK = 64;
+// the least number of outcomes per thread when computing the weights
+constexpr int64_t MIN_OUTCOMES_PER_THREAD = 1 << 16;
 
 namespace poincare {
 
-    Sampler::Sampler(real distribution_power_, const std::vector<int64_t>& counts, int64_t table_size) : distribution_power (distribution_power_) {
-        real z = 0.0;
-        for (size_t i = 0; i < counts.size(); i++) {
-            z += pow(counts[i], distribution_power);
-        }
-        for (size_t i = 0; i < counts.size(); i++) {
-            real c = pow(counts[i], distribution_power);
-            for (size_t j = 0; j < c * table_size / z; j++) {
-                samples.push_back(i);
+    Sampler::Sampler(real distribution_power_, const std::vector<int64_t>& counts, int32_t threads) : distribution_power (distribution_power_) {
+        const int64_t n = counts.size();
+        // the weights, and their partial sums per thread
+        std::vector<double> weights(n);
+        threads = std::max<int64_t>(1, std::min<int64_t>(threads, n / MIN_OUTCOMES_PER_THREAD));
+        std::vector<double> partial_sums(threads, 0.);
+        auto compute_weights = [&](int32_t thread) {
+            for (int64_t i = n * thread / threads; i < n * (thread + 1) / threads; i++) {
+                weights[i] = std::pow(double(counts[i]), double(distribution_power));
+                partial_sums[thread] += weights[i];
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int32_t thread = 1; thread < threads; thread++) {
+            workers.push_back(std::thread(compute_weights, thread));
+        }
+        compute_weights(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        double z = 0.0;
+        for (double partial_sum : partial_sums) {
+            z += partial_sum;
+        }
+        if (!(z > 0)) {
+            throw std::invalid_argument("no outcome has a positive sampling weight");
+        }
+
+        // Vose's method: pair each outcome of less than the mean weight with
+        // one of more, which fills up the rest of its bucket
+        std::vector<node_t> small, large;
+        node_t fallback = 0; // some outcome of positive weight
+        for (int64_t i = 0; i < n; i++) {
+            weights[i] *= n / z;
+            (weights[i] < 1 ? small : large).push_back(i);
+            if (weights[i] > weights[fallback]) {
+                fallback = i;
+            }
+        }
+        const double range = 4294967296.; // 2^32
+        buckets.resize(n);
+        while (!small.empty() && !large.empty()) {
+            node_t less = small.back();
+            node_t more = large.back();
+            small.pop_back();
+            buckets[less].threshold = uint32_t(std::min(weights[less] * range, range - 1));
+            buckets[less].alias = more;
+            weights[more] -= 1 - weights[less];
+            if (weights[more] < 1) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // what remains has (up to rounding) the mean weight, except that an
+        // outcome of weight zero must never be drawn
+        for (std::vector<node_t>* rest : {&small, &large}) {
+            for (node_t i : *rest) {
+                bool positive = counts[i] > 0 || distribution_power == 0;
+                buckets[i].threshold = 0;
+                buckets[i].alias = positive ? i : fallback;
             }
         }
     }
 
-    int32_t Sampler::get_sample(std::vector<int32_t> exclude, std::minstd_rand& rng) const {
-        int32_t sample;
+    node_t Sampler::get_sample(const std::vector<node_t>& exclude, Rng& rng) const {
+        node_t sample;
         do {
-            sample = samples[rng() % samples.size()];
+            sample = draw(rng);
         } while (std::find(exclude.begin(), exclude.end(), sample) != exclude.end());
         return sample;
     }
+
+    node_t Sampler::get_sample(const ExclusionIndex& exclusions, node_t source, Rng& rng,
+                               RejectionStats& stats) const {
+        int64_t rejections = 0;
+        node_t sample = draw(rng);
+        while (exclusions.excludes(source, sample)) {
+            rejections++;
+            sample = draw(rng);
+        }
+        stats.samples++;
+        stats.rejections += rejections;
+        stats.max_rejections = std::max(stats.max_rejections, rejections);
+        return sample;
+    }
+
+    int32_t Sampler::sample_batch(const ExclusionIndex& exclusions, node_t source, int32_t count, node_t* out,
+                                  Rng& rng, RejectionStats& stats, int64_t& budget) const {
+        uint64_t bits[SAMPLE_BLOCK];
+        node_t drawn[SAMPLE_BLOCK];
+        int64_t rejections = 0; // in a row
+        int32_t filled = 0;
+        while (filled < count && budget > 0) {
+            const int32_t block = std::min<int64_t>(std::min(count - filled, SAMPLE_BLOCK), budget);
+            budget -= block;
+            for (int32_t i = 0; i < block; i++) {
+                bits[i] = rng();
+            }
+            for (int32_t i = 0; i < block; i++) {
+                drawn[i] = outcome(bits[i], rng);
+            }
+            for (int32_t i = 0; i < block; i++) {
+                if (exclusions.excludes(source, drawn[i])) {
+                    stats.rejections++;
+                    stats.max_rejections = std::max(stats.max_rejections, ++rejections);
+                } else {
+                    rejections = 0;
+                    out[filled++] = drawn[i];
+                }
+            }
+        }
+        stats.samples += filled;
+        return filled;
+    }
 }
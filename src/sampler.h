@@ -1,14 +1,33 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
+#include "exclusion.h"
+#include "node.h"
+#include "random.h"
 #include "real.h"
 
 namespace poincare {
 
 class Sampler {
+    /**
+     * Draws outcomes 0, ..., N - 1 with probability proportional to their
+     * counts raised to a power, in constant time, using an alias table
+     * (Vose's method).
+     */
+
     protected:
-        std::vector<int32_t> samples;
+        struct Bucket {
+            // draw the outcome of the bucket itself if 32 uniform random
+            // bits are below this, otherwise `alias` (which is the bucket
+            // itself if it is never to be replaced)
+            uint32_t threshold;
+            node_t alias;
+        };
+
+        std::vector<Bucket> buckets;
         const real distribution_power;
 
     public:
@@ -16,12 +35,53 @@ class Sampler {
          * `distribution_power_` is the power to which the counts are raised
          * prior to normalisation.
          * `counts` gives observed number of occurrences of each outcome.
+         * The weights are computed by `threads` threads.    Throws
+         * std::invalid_argument if no outcome has a positive weight.
          **/
-        Sampler(real distribution_power_, const std::vector<int64_t>& counts, int64_t table_size);
+        Sampler(real distribution_power_, const std::vector<int64_t>& counts, int32_t threads = 1);
 
         /**
-         * Draw a single sample. 
+         * Draw a single sample that is not in `exclude`.
          */
-        int32_t get_sample(std::vector<int32_t> exclude, std::minstd_rand& rng) const;
+        node_t get_sample(const std::vector<node_t>& exclude, Rng& rng) const;
+
+        /**
+         * Draw a single sample that is not excluded for `source` by
+         * `exclusions`, recording the draws rejected in `stats`.
+         */
+        node_t get_sample(const ExclusionIndex& exclusions, node_t source, Rng& rng,
+                          RejectionStats& stats) const;
+
+        /**
+         * Draw up to `count` samples (independently, so not necessarily
+         * distinct) that are not excluded for `source` by `exclusions`, into
+         * `out`, recording the draws rejected in `stats`, and return the
+         * number drawn.    Each draw, accepted or not, uses up one of `budget`;
+         * fewer than `count` are drawn only if it runs out.    The random
+         * numbers are drawn and mapped to outcomes in blocks, rather than one
+         * at a time.
+         */
+        int32_t sample_batch(const ExclusionIndex& exclusions, node_t source, int32_t count, node_t* out,
+                             Rng& rng, RejectionStats& stats, int64_t& budget) const;
+
+    protected:
+        /**
+         * Return the outcome for 64 random bits: the top 32 choose the bucket,
+         * the bottom 32 decide between it and its alias.    (With more than 2^32
+         * buckets, the bucket is chosen by a further 64 random bits.)
+         */
+        node_t outcome(uint64_t bits, Rng& rng) const {
+            if (sizeof(node_t) > sizeof(uint32_t) && buckets.size() > std::numeric_limits<uint32_t>::max()) {
+                // too many buckets to choose from with 32 bits
+                const node_t bucket = rng.bounded64(buckets.size());
+                return uint32_t(bits) < buckets[bucket].threshold ? bucket : buckets[bucket].alias;
+            }
+            const uint32_t bucket = rng.bounded(buckets.size(), uint32_t(bits >> 32));
+            return uint32_t(bits) < buckets[bucket].threshold ? bucket : buckets[bucket].alias;
+        }
+
+        node_t draw(Rng& rng) const {
+            return outcome(rng(), rng);
+        }
 };
 }
@@ -0,0 +1,42 @@
+#include "shuffle.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace poincare {
+
+namespace {
+
+/**
+ * Shuffle [first, first + count) (Fisher-Yates).
+ */
+template <typename Element>
+void shuffle_range(Element* first, int64_t count, Rng& rng) {
+    for (int64_t i = count - 1; i > 0; i--) {
+        const int64_t j = i < std::numeric_limits<uint32_t>::max() ? rng.bounded(uint32_t(i + 1)) : rng.bounded64(i + 1);
+        std::swap(first[i], first[j]);
+    }
+}
+
+}
+
+void blocked_shuffle(int64_t count, int64_t block, Rng& rng, std::vector<int64_t>& order) {
+    const int64_t blocks = count == 0 ? 0 : (count - 1) / block + 1;
+    std::vector<int64_t> block_order(blocks);
+    for (int64_t b = 0; b < blocks; b++) {
+        block_order[b] = b;
+    }
+    shuffle_range(block_order.data(), blocks, rng);
+    order.resize(count);
+    int64_t filled = 0;
+    for (int64_t b : block_order) {
+        const int64_t begin = filled;
+        for (int64_t i = b * block; i < std::min(count, (b + 1) * block); i++) {
+            order[filled++] = i;
+        }
+        shuffle_range(order.data() + begin, filled - begin, rng);
+    }
+}
+
+}
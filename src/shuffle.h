@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "random.h"
+
+namespace poincare {
+
+/**
+ * Fill `order` with a random permutation of 0, ..., count - 1 that keeps
+ * blocks together: the indices are split into consecutive blocks of `block`
+ * (the last possibly shorter), the blocks are put in a random order and the
+ * indices within each block are shuffled.    Visiting an array in this order
+ * reads it one block at a time, so that with blocks that fit in cache the
+ * reads remain mostly sequential.    With block >= count, the permutation is
+ * uniformly random.
+ */
+void blocked_shuffle(int64_t count, int64_t block, Rng& rng, std::vector<int64_t>& order);
+
+}
@@ -0,0 +1,90 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace poincare {
+
+// the number of cursors per cache line
+constexpr int64_t CURSOR_SPACING = 64 / sizeof(std::atomic<int64_t>);
+
+ThreadPool::ThreadPool(int32_t workers) : task_(nullptr), generation_(0), running_(0), stopping_(false) {
+    for (int32_t worker = 0; worker < workers; worker++) {
+        threads_.push_back(std::thread(&ThreadPool::work, this, worker));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    started_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void(int32_t)>& task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    running_ = size();
+    generation_++;
+    started_.notify_all();
+    finished_.wait(lock, [this]() { return running_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::work(int32_t worker) {
+    int64_t generation = 0;
+    while (true) {
+        const std::function<void(int32_t)>* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            started_.wait(lock, [this, generation]() { return stopping_ || generation_ != generation; });
+            if (stopping_) {
+                return;
+            }
+            generation = generation_;
+            task = task_;
+        }
+        (*task)(worker);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--running_ == 0) {
+            finished_.notify_one();
+        }
+    }
+}
+
+WorkQueues::WorkQueues(int32_t workers, int64_t total, int64_t chunk)
+    : workers_(workers), chunk_(chunk), cursors_(new std::atomic<int64_t>[workers * CURSOR_SPACING]) {
+    for (int32_t w = 0; w < workers; w++) {
+        starts_.push_back(total * w / workers);
+        ends_.push_back(total * (w + 1) / workers);
+    }
+    reset();
+}
+
+void WorkQueues::reset() {
+    for (int32_t w = 0; w < workers_; w++) {
+        cursors_[w * CURSOR_SPACING].store(starts_[w]);
+    }
+}
+
+bool WorkQueues::claim(int32_t worker, int64_t& begin, int64_t& end) {
+    // our own range first, then the others in turn
+    for (int32_t i = 0; i < workers_; i++) {
+        int32_t victim = (worker + i) % workers_;
+        std::atomic<int64_t>& cursor = cursors_[victim * CURSOR_SPACING];
+        if (cursor.load(std::memory_order_relaxed) >= ends_[victim]) {
+            continue;
+        }
+        begin = cursor.fetch_add(chunk_);
+        if (begin < ends_[victim]) {
+            end = std::min(begin + chunk_, ends_[victim]);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace poincare {
+
+class ThreadPool {
+    /**
+     * A fixed set of worker threads, created once and reused: each call to
+     * run() hands the same task to every worker and returns once all have
+     * finished it.
+     */
+
+    public:
+        explicit ThreadPool(int32_t workers);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int32_t size() const { return threads_.size(); }
+
+        /**
+         * Call task(worker) on each worker, worker = 0, ..., size() - 1, in
+         * parallel, returning when all calls have returned.
+         */
+        void run(const std::function<void(int32_t)>& task);
+
+    protected:
+        void work(int32_t worker);
+
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable started_;
+        std::condition_variable finished_;
+        const std::function<void(int32_t)>* task_;
+        int64_t generation_;
+        int32_t running_;
+        bool stopping_;
+};
+
+class WorkQueues {
+    /**
+     * Hands out the indices 0, ..., total - 1 in chunks to a number of
+     * workers.    Each worker has its own contiguous range of the indices,
+     * claimed from an atomic cursor; once its range is used up, a worker
+     * steals chunks from the ranges of the others.    Every index is handed
+     * out exactly once (until reset).
+     */
+
+    public:
+        WorkQueues(int32_t workers, int64_t total, int64_t chunk);
+
+        /**
+         * Make all the indices available again.
+         */
+        void reset();
+
+        /**
+         * Claim the next chunk [begin, end) for `worker`, from its own range if
+         * possible, otherwise from another's.    Return false if none remain.
+         */
+        bool claim(int32_t worker, int64_t& begin, int64_t& end);
+
+    protected:
+        const int32_t workers_;
+        const int64_t chunk_;
+        std::vector<int64_t> starts_;
+        std::vector<int64_t> ends_;
+        // the cursor of worker w is cursors_[w * CURSOR_SPACING], so that
+        // the cursors are on different cache lines
+        std::unique_ptr<std::atomic<int64_t>[]> cursors_;
+};
+
+}
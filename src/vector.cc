@@ -10,125 +10,150 @@
 
 namespace poincare {
 
-    Vector::Vector(int64_t m) {
+    template <typename T>
+    Vector<T>::Vector(int64_t m) {
         dimension_ = m;
-        data_ = new real[m];
+        data_ = new T[m];
+        owns_data_ = true;
         zero();
     }
 
-    Vector::Vector(const Vector& v) {
+    template <typename T>
+    Vector<T>::Vector(const Vector& v) {
         dimension_ = v.dimension_;
-        data_ = new real[dimension_];
+        data_ = new T[dimension_];
+        owns_data_ = true;
         for (int64_t i = 0; i < dimension_; ++i) {
             data_[i] = v[i];
         }
     }
 
-    Vector& Vector::operator=(const Vector& v) {
-        delete[] data_;
-        dimension_ = v.dimension_;
-        data_ = new real[dimension_];
+    template <typename T>
+    Vector<T>::Vector(T* data, int64_t m) {
+        dimension_ = m;
+        data_ = data;
+        owns_data_ = false;
+    }
+
+    template <typename T>
+    Vector<T>& Vector<T>::operator=(const Vector<T>& v) {
+        if (dimension_ != v.dimension_) {
+            // views can not be resized
+            assert(owns_data_);
+            delete[] data_;
+            dimension_ = v.dimension_;
+            data_ = new T[dimension_];
+        }
         for (int64_t i = 0; i < dimension_; ++i) {
             data_[i] = v[i];
         }
         return *this;
     }
 
-    Vector::~Vector() {
-        delete[] data_;
+    template <typename T>
+    Vector<T>::~Vector() {
+        if (owns_data_) {
+            delete[] data_;
+        }
     }
 
-    int64_t Vector::size() const {
+    template <typename T>
+    int64_t Vector<T>::size() const {
         return dimension_;
     }
 
-    void Vector::zero() {
+    template <typename T>
+    void Vector<T>::zero() {
         for (int64_t i = 0; i < dimension_; i++) {
             data_[i] = 0.0;
         }
     }
 
-    void Vector::multiply(real a) {
-        for (int64_t i = 0; i < dimension_; i++) {
-            data_[i] *= a;
-        }
+    template <typename T>
+    void Vector<T>::multiply(T a) {
+        kernels<T>().scale(data_, a, dimension_);
     }
 
-    void Vector::add(const Vector& source) {
+    template <typename T>
+    void Vector<T>::add(const Vector& source) {
         assert(dimension_ == source.dimension_);
-        for (int64_t i = 0; i < dimension_; i++) {
-            data_[i] += source.data_[i];
-        }
+        kernels<T>().axpy(data_, 1, source.data_, dimension_);
     }
 
-    void Vector::add(const Vector& source, real s) {
+    template <typename T>
+    void Vector<T>::add(const Vector& source, T s) {
         assert(dimension_ == source.dimension_);
-        for (int64_t i = 0; i < dimension_; i++) {
-            data_[i] += s * source.data_[i];
-        }
+        kernels<T>().axpy(data_, s, source.data_, dimension_);
     }
 
-    void Vector::to_ball_point() {
-        real denom = data_[dimension_ - 1] + 1;
+    template <typename T>
+    void Vector<T>::to_ball_point() {
+        T denom = data_[dimension_ - 1] + 1;
         data_[dimension_ - 1] = 0;
         multiply(1. / denom);
     }
 
-    void Vector::to_hyperboloid_point() {
-        real norm_sqd = minkowski_dot(*this, *this);
+    template <typename T>
+    void Vector<T>::to_hyperboloid_point() {
+        T norm_sqd = minkowski_dot(*this, *this);
         multiply(2. / (1 - norm_sqd));
         data_[dimension_ - 1] = (1 + norm_sqd) / (1 - norm_sqd);
     }
 
-    void Vector::to_ball_tangent(const Vector& hyperboloid_point) {
-        real denom = hyperboloid_point[dimension_ - 1] + 1;
+    template <typename T>
+    void Vector<T>::to_ball_tangent(const Vector& hyperboloid_point) {
+        T denom = hyperboloid_point[dimension_ - 1] + 1;
         for (int64_t i = 0; i < dimension_ - 1; i++) {
             data_[i] = (data_[i] - hyperboloid_point[i] * data_[dimension_ - 1] / denom) / denom;
         }
         data_[dimension_ - 1] = 0;
     }
 
-    void Vector::to_hyperboloid_tangent(const Vector& ball_point) {
-        Vector hyperboloid_pt(ball_point);
+    template <typename T>
+    void Vector<T>::to_hyperboloid_tangent(const Vector& ball_point) {
+        Vector<T> hyperboloid_pt(ball_point);
         hyperboloid_pt.to_hyperboloid_point();
-        real dot_with_bp = dot(ball_point, *this);
-        real multiplier = hyperboloid_pt[dimension_ - 1] + 1;
+        T dot_with_bp = dot(ball_point, *this);
+        T multiplier = hyperboloid_pt[dimension_ - 1] + 1;
         for (int i = 0; i < dimension_ - 1; i++) {
             data_[i] = multiplier * (hyperboloid_pt[i] * dot_with_bp + data_[i]);
         }
-        data_[dimension_ - 1] = pow(multiplier, 2) * dot_with_bp;
+        data_[dimension_ - 1] = multiplier * multiplier * dot_with_bp;
     }
 
 
-    void Vector::geodesic_update(const Vector& tangent_unit_vec, real step_size) {
+    template <typename T>
+    void Vector<T>::geodesic_update(const Vector& tangent_unit_vec, T step_size) {
         multiply(std::cosh(step_size));
         add(tangent_unit_vec, std::sinh(step_size));
         ensure_on_hyperboloid(); // needed?
     }
 
-    void Vector::project_onto_tangent_space(const Vector& hyperboloid_point) {
-        real mdp = minkowski_dot(hyperboloid_point, *this);
+    template <typename T>
+    void Vector<T>::project_onto_tangent_space(const Vector& hyperboloid_point) {
+        T mdp = minkowski_dot(hyperboloid_point, *this);
         add(hyperboloid_point, mdp);
     }
 
-    void Vector::ensure_on_hyperboloid() {
-        real euc_norm_sq = 0;
-        for (int64_t i = 0; i < dimension_ - 1; ++i) {
-            euc_norm_sq += std::pow(data_[i], 2);
-        }
+    template <typename T>
+    void Vector<T>::ensure_on_hyperboloid() {
+        T euc_norm_sq = kernels<T>().dot(data_, data_, dimension_ - 1);
         data_[dimension_ - 1] = std::sqrt(euc_norm_sq + 1);
     }
 
-    real& Vector::operator[](int64_t i) {
+    template <typename T>
+    T& Vector<T>::operator[](int64_t i) {
         return data_[i];
     }
 
-    const real& Vector::operator[](int64_t i) const {
+    template <typename T>
+    const T& Vector<T>::operator[](int64_t i) const {
         return data_[i];
     }
 
-    std::ostream& operator<<(std::ostream& os, const Vector& v) {
-        os.precision(std::numeric_limits<real>::digits10 + 1);
+    template <typename T>
+    std::ostream& operator<<(std::ostream& os, const Vector<T>& v) {
+        os.precision(std::numeric_limits<T>::digits10 + 1);
         for (int64_t j = 0; j < v.dimension_ - 1; j++) {
             os << v.data_[j] << ' ';
         }
@@ -136,13 +161,14 @@ namespace poincare {
         return os;
     }
 
-    void random_hyperboloid_point(Vector& vector, std::minstd_rand& rng, real std_dev) {
-        std::normal_distribution<real> normal_dist(0, std_dev);
+    template <typename T>
+    void random_hyperboloid_point(Vector<T>& vector, std::minstd_rand& rng, double std_dev) {
+        std::normal_distribution<T> normal_dist(0, std_dev);
         int64_t n = vector.size();
         // sample a tangent vector at the basepoint from a normal
         // distribution, i.e. sample the first dimension_-1 components
-        Vector tangent(n);
-        real tangent_norm = 0;
+        Vector<T> tangent(n);
+        T tangent_norm = 0;
         for (int64_t j = 0; j < n - 1; ++j) {
             tangent[j] = normal_dist(rng);
             tangent_norm += tangent[j] * tangent[j];
@@ -155,15 +181,29 @@ namespace poincare {
         vector.geodesic_update(tangent, tangent_norm);
     }
 
-    real distance(const Vector& point0, const Vector& point1) {
+    template <typename T>
+    T distance(const Vector<T>& point0, const Vector<T>& point1) {
         return std::acosh(-minkowski_dot(point0, point1));
     }
 
-    real Vector::squared_norm() const {
-        real res = 0;
-        for (int32_t i = 0; i < size(); i++) {
-            res += pow(data_[i], 2);
-        }
-        return res;
+    template <typename T>
+    T Vector<T>::squared_norm() const {
+        return kernels<T>().dot(data_, data_, dimension_);
     }
+
+    template class Vector<float>;
+    template class Vector<double>;
+    template class Vector<long double>;
+
+    template std::ostream& operator<<(std::ostream&, const Vector<float>&);
+    template std::ostream& operator<<(std::ostream&, const Vector<double>&);
+    template std::ostream& operator<<(std::ostream&, const Vector<long double>&);
+
+    template void random_hyperboloid_point(Vector<float>&, std::minstd_rand&, double);
+    template void random_hyperboloid_point(Vector<double>&, std::minstd_rand&, double);
+    template void random_hyperboloid_point(Vector<long double>&, std::minstd_rand&, double);
+
+    template float distance(const Vector<float>&, const Vector<float>&);
+    template double distance(const Vector<double>&, const Vector<double>&);
+    template long double distance(const Vector<long double>&, const Vector<long double>&);
 }
@@ -5,27 +5,36 @@
 #include <random>
 #include <assert.h>
 
-#include "real.h"
+#include "kernels.h"
 
 namespace poincare {
 
+template <typename T>
 class Vector {
     /**
      * Represent vectors in Minkowski space, where the last co-ordinate is
-     * considered to be time-like.
+     * considered to be time-like.    `T` is the scalar type of the entries
+     * (float, double or long double).
      */
 
     public:
         int64_t dimension_;
-        real* data_;
+        T* data_;
 
         explicit Vector(int64_t);
         explicit Vector(const Vector&);
+
+        /**
+         * Construct a non-owning view onto the `m` entries starting at `data`
+         * (e.g. a row of a Matrix).    Modifying the view modifies the
+         * underlying entries; assigning to it copies into them.
+         */
+        Vector(T* data, int64_t m);
         ~Vector();
 
         Vector& operator= (const Vector&);
-        real& operator[](int64_t);
-        const real& operator[](int64_t) const;
+        T& operator[](int64_t);
+        const T& operator[](int64_t) const;
 
         /**
          * Return the length of this vector.
@@ -40,7 +49,7 @@ class Vector {
         /**
          * Multiply all entries by the given value, in place.
          */
-        void multiply(real);
+        void multiply(T);
 
         /**
          * Add the given vector to this vector.
@@ -50,7 +59,7 @@ class Vector {
         /**
          * Add the specified multiple of the given vector to this vector.
          */
-        void add(const Vector& other_vector, real scalar);
+        void add(const Vector& other_vector, T scalar);
 
         /**
          * Calculate (in place) the projection of this hyperboloid point to the
@@ -89,7 +98,7 @@ class Vector {
          * `step_size`.
          * Pre: `tangent_unit_vec` is a unit vector; `step_size` > 0.
          */
-        void geodesic_update(const Vector& tangent_unit_vec, real step_size);
+        void geodesic_update(const Vector& tangent_unit_vec, T step_size);
 
         /**
          * Ensure that this time-like point is on the hyperboloid by
@@ -97,42 +106,35 @@ class Vector {
          */
         void ensure_on_hyperboloid();
 
-		real squared_norm() const;
+		T squared_norm() const;
+
+    protected:
+        // whether data_ was allocated by (and so is freed by) this vector
+        bool owns_data_;
 };
 
-std::ostream& operator<<(std::ostream&, const Vector&);
+template <typename T>
+std::ostream& operator<<(std::ostream&, const Vector<T>&);
 
 /**
  * Return the Minkowski inner product of the two vectors provided, where the
  * last co-ordinate is interpreted as being time-like.
  */
-inline real minkowski_dot(const Vector& v, const Vector& w) {
-    real result = 0;
-    int64_t n = v.size();
-
-    for (int64_t i = 0; i < n-1; ++i) {
-        result += v[i]*w[i];
-    }
-    result -= v[n-1]*w[n-1];
-    return result;
+template <typename T>
+inline T minkowski_dot(const Vector<T>& v, const Vector<T>& w) {
+    return kernels<T>().minkowski_dot(v.data_, w.data_, v.size());
 }
 /*
  * Return the inner product of the two vectors provided.
  */
-inline real dot(const Vector& v, const Vector& w) {
-    real result = 0;
-    for (int64_t i = 0; i < v.size(); ++i) {
-        result += v[i]*w[i];
-    }
-    return result;
+template <typename T>
+inline T dot(const Vector<T>& v, const Vector<T>& w) {
+    return kernels<T>().dot(v.data_, w.data_, v.size());
 }
 
-inline real squared_dist(const Vector& v, const Vector& w) {
-    real result = 0;
-    for (int64_t i = 0; i < v.size(); ++i) {
-        result += pow(v[i] - w[i], 2);
-    }
-    return result;
+template <typename T>
+inline T squared_dist(const Vector<T>& v, const Vector<T>& w) {
+    return kernels<T>().squared_dist(v.data_, w.data_, v.size());
 }
 
 
@@ -141,18 +143,21 @@ inline real squared_dist(const Vector& v, const Vector& w) {
  * around the base point with the hyperbolic distance from the base
  * point normally distributed with standard deviation std_dev.
  */
-void random_hyperboloid_point(Vector& vector, std::minstd_rand& rng, real std_dev);
+template <typename T>
+void random_hyperboloid_point(Vector<T>& vector, std::minstd_rand& rng, double std_dev);
 
 /**
  * Return the distance between the two points on the hyperboloid.
  */
-real distance(const Vector& point0, const Vector& point1);
+template <typename T>
+T distance(const Vector<T>& point0, const Vector<T>& point1);
 
 /**
  * Return the gradient of the distance.
  * Gradient is in the ambient Minkowski space (so needs to be projected
  * onto the tangent plane).
  */
-void distance_gradient(const Vector& varying_pt, const Vector& fixed_pt, Vector& gradient);
+template <typename T>
+void distance_gradient(const Vector<T>& varying_pt, const Vector<T>& fixed_pt, Vector<T>& gradient);
 
 }
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace testing_hooks {
+
+/**
+ * Return the number of calls to the global operator new (of any form) made so
+ * far by the test binary, from any thread.    Use the difference between two
+ * calls to check that a section of code does not allocate.
+ */
+int64_t allocation_count();
+
+}
@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Replace the global allocation functions for the whole test binary, counting
+// each allocation (the array and nothrow forms forward to these by default).
+
+namespace {
+
+std::atomic<int64_t> allocations(0);
+
+}
+
+void* operator new(std::size_t size) {
+    allocations++;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace testing_hooks {
+
+int64_t allocation_count() {
+    return allocations;
+}
+
+}
+
+namespace {
+
+TEST(AllocationCounterTest, countsAllocations) {
+    int64_t before = testing_hooks::allocation_count();
+    std::vector<int64_t> values(8, before);
+    EXPECT_EQ(1, testing_hooks::allocation_count() - values[7]);
+}
+
+}
@@ -0,0 +1,37 @@
+#include "gtest/gtest.h"
+#include "barrier.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(BarrierTest, noThreadPassesEarly) {
+    const int32_t threads = 4;
+    const int32_t phases = 100;
+    poincare::Barrier barrier(threads);
+    std::atomic<int32_t> arrived(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    for (int32_t t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&]() {
+            for (int32_t phase = 0; phase < phases; phase++) {
+                arrived++;
+                barrier.wait();
+                // everyone has arrived for this phase, and no-one can arrive
+                // for the next until we have all passed the second wait
+                if (arrived.load() != threads * (phase + 1)) {
+                    failed = true;
+                }
+                barrier.wait();
+            }
+        }));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(threads * phases, arrived.load());
+}
+
+}
@@ -1,32 +1,29 @@
 #include "gtest/gtest.h"
 #include "digraph.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 
 namespace {
 
-TEST(DigraphTest, TestCreateNode) {
-    poincare::Node n("cat", 2);
-    EXPECT_EQ(n.name, "cat");
-    EXPECT_EQ(n.enumeration, 2);
-    EXPECT_EQ(n.count_as_source, 0);
-    EXPECT_EQ(n.count_as_target, 0);
-    EXPECT_EQ(n.target_enums.size(), 0);
-}
-
-TEST(DigraphTest, TestCreateNodeNameIsCopy) {
-    std::string name = "cat";
-    poincare::Node node(name, 2);
-    name[2] = 'r';
-    EXPECT_EQ(node.name, "cat");
-}
-
-TEST(DigraphTest, TestCreateEdge) {
-    poincare::Node n0("cat", 2);
-    poincare::Node n1("mammal", 3);
-    poincare::Edge edge(n0, n1);
-    EXPECT_EQ(edge.target.name, "mammal");
-    EXPECT_EQ(n0.count_as_target, 0);
-    EXPECT_EQ(n1.count_as_target, 1);
-    EXPECT_EQ(n0.target_enums[0], n1.enumeration); 
+TEST(DigraphTest, TestAdjacency) {
+    std::string spec = "cat\tmammal\ncat\tanimal\nmammal\tanimal\ncat\tmammal\n";
+    std::istringstream in(spec);
+    poincare::Digraph dig(in);
+    EXPECT_EQ(3, dig.names.size());
+    EXPECT_EQ("cat", dig.names.name(0));
+    EXPECT_EQ("mammal", dig.names.name(1));
+    EXPECT_EQ("animal", dig.names.name(2));
+    EXPECT_EQ(std::vector<poincare::node_t>({0, 0, 1, 0}), dig.edge_sources);
+    EXPECT_EQ(std::vector<poincare::node_t>({1, 2, 2, 1}), dig.edge_targets);
+    EXPECT_EQ(std::vector<int64_t>({3, 1, 0}), dig.count_as_source);
+    EXPECT_EQ(std::vector<int64_t>({0, 2, 2}), dig.count_as_target);
+    // the targets of each node in the order of the edges, with repeats
+    EXPECT_EQ(std::vector<int64_t>({0, 3, 4, 4}), dig.target_offsets);
+    EXPECT_EQ(std::vector<poincare::node_t>({1, 2, 1, 2}), dig.target_enums);
 }
 
 TEST(DigraphTest, TestCreateDigraph) {
@@ -34,15 +31,14 @@ TEST(DigraphTest, TestCreateDigraph) {
     std::istringstream in(spec);
     poincare::Digraph dig(in);
     EXPECT_EQ(dig.node_count(), 6);
-    EXPECT_EQ(dig.edges.size(), 5);
-    poincare::Edge* edge_ptr = dig.edges[0];
-    EXPECT_EQ(edge_ptr->source.name, "car");
-    EXPECT_EQ(edge_ptr->target.name, "vehicle");
-    EXPECT_EQ(dig.node_count(), dig.enumeration2node.size());
-    EXPECT_EQ(dig.name2node["thing"]->count_as_target, 3);
-    EXPECT_EQ(dig.name2node["thing"]->count_as_source, 0);
-    EXPECT_EQ(dig.name2node["car"]->count_as_source, 1);
-    EXPECT_EQ(dig.name2node["car"]->target_enums[0], dig.name2node["vehicle"]->enumeration);
+    EXPECT_EQ(dig.edge_count(), 5);
+    EXPECT_EQ(dig.names.name(dig.edge_sources[0]), "car");
+    EXPECT_EQ(dig.names.name(dig.edge_targets[0]), "vehicle");
+    EXPECT_EQ(dig.node_count(), dig.names.size());
+    EXPECT_EQ(dig.count_as_target[dig.names.find("thing")], 3);
+    EXPECT_EQ(dig.count_as_source[dig.names.find("thing")], 0);
+    EXPECT_EQ(dig.count_as_source[dig.names.find("car")], 1);
+    EXPECT_EQ(dig.target_enums[dig.target_offsets[dig.names.find("car")]], dig.names.find("vehicle"));
 }
 
 TEST(DigraphTest, TestCreateDigraphEmpty) {
@@ -50,7 +46,7 @@ TEST(DigraphTest, TestCreateDigraphEmpty) {
     std::istringstream in(spec);
     poincare::Digraph dig(in);
     EXPECT_EQ(dig.node_count(), 0);
-    EXPECT_EQ(dig.edges.size(), 0);
+    EXPECT_EQ(dig.edge_count(), 0);
 }
 
 TEST(DigraphTest, TestCreateDigraphTrailingLinefeed) {
@@ -58,7 +54,7 @@ TEST(DigraphTest, TestCreateDigraphTrailingLinefeed) {
     std::istringstream in(spec);
     poincare::Digraph dig(in);
     EXPECT_EQ(dig.node_count(), 6);
-    EXPECT_EQ(dig.edges.size(), 5);
+    EXPECT_EQ(dig.edge_count(), 5);
 }
 
 TEST(DigraphTest, TestCreateDigraphTooManyColumns) {
@@ -71,4 +67,147 @@ TEST(DigraphTest, TestCreateDigraphTooManyColumns) {
     }
 }
 
+TEST(DigraphTest, TestCreateDigraphTrailingSeparator) {
+    // as for std::getline, a separator at the end of the line starts no field
+    std::string spec = "car\tvehicle\t\nvehicle\tthing\n";
+    std::istringstream in(spec);
+    poincare::Digraph dig(in);
+    EXPECT_EQ(dig.node_count(), 3);
+    EXPECT_EQ(dig.count_as_target[dig.names.at("vehicle")], 1);
+}
+
+TEST(DigraphTest, TestCreateDigraphTooFewColumns) {
+    for (std::string spec : {"car\tvehicle\ncar\n", "car\tvehicle\n\nmammal\tthing", "car\t\n"}) {
+        std::istringstream in(spec);
+        EXPECT_THROW(poincare::Digraph dig(in), std::runtime_error);
+    }
+}
+
+// Write `contents` to a temporary file, returning its name.
+std::string write_temporary(const std::string& contents) {
+    std::string filename = testing::TempDir() + "digraph_test.tsv";
+    std::ofstream out(filename);
+    out << contents;
+    return filename;
+}
+
+// a graph of many lines, with names repeated across the whole file
+std::string large_graph() {
+    std::ostringstream out;
+    for (int i = 0; i < 200000; i++) {
+        out << "node" << (i * 7919) % 100003 << "\tparent_node" << (i * 31) % 1009 << "\n";
+    }
+    return out.str();
+}
+
+TEST(DigraphTest, TestParallelParseMatchesSequential) {
+    std::string spec = large_graph();
+    std::string filename = write_temporary(spec);
+    std::istringstream in(spec);
+    poincare::Digraph sequential(in);
+    poincare::Digraph parallel(filename, 4);
+    ASSERT_EQ(sequential.node_count(), parallel.node_count());
+    for (poincare::node_t n = 0; n < sequential.node_count(); n++) {
+        EXPECT_EQ(sequential.names.name(n), parallel.names.name(n));
+    }
+    EXPECT_EQ(sequential.edge_sources, parallel.edge_sources);
+    EXPECT_EQ(sequential.edge_targets, parallel.edge_targets);
+    EXPECT_EQ(sequential.count_as_target, parallel.count_as_target);
+    EXPECT_EQ(sequential.target_offsets, parallel.target_offsets);
+    EXPECT_EQ(sequential.target_enums, parallel.target_enums);
+    std::remove(filename.c_str());
+}
+
+TEST(DigraphTest, TestParallelParseReportsLine) {
+    std::string spec = large_graph() + "node1\tnode2\tnode3\n";
+    std::string filename = write_temporary(spec);
+    try {
+        poincare::Digraph dig(filename, 4);
+        FAIL();
+    } catch (const std::runtime_error& error) {
+        EXPECT_EQ(std::string("expected exactly two tab-separated columns at line 200000"), error.what());
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(DigraphTest, TestCreateDigraphFromFile) {
+    std::string filename = write_temporary("");
+    poincare::Digraph empty(filename, 4);
+    EXPECT_EQ(empty.node_count(), 0);
+    std::remove(filename.c_str());
+    EXPECT_THROW(poincare::Digraph missing(filename, 4), std::invalid_argument);
+}
+
+// Set the modification time of the file to `seconds` since the epoch.
+void set_mtime(const std::string& filename, time_t seconds) {
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = seconds;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    ASSERT_EQ(0, utimensat(AT_FDCWD, filename.c_str(), times, 0));
+}
+
+void expect_same_graph(const poincare::Digraph& expected, const poincare::Digraph& actual) {
+    ASSERT_EQ(expected.node_count(), actual.node_count());
+    for (poincare::node_t n = 0; n < expected.node_count(); n++) {
+        EXPECT_EQ(expected.names.name(n), actual.names.name(n));
+        EXPECT_EQ(n, actual.names.find(expected.names.name(n)));
+    }
+    EXPECT_EQ(expected.edge_sources, actual.edge_sources);
+    EXPECT_EQ(expected.edge_targets, actual.edge_targets);
+    EXPECT_EQ(expected.count_as_source, actual.count_as_source);
+    EXPECT_EQ(expected.count_as_target, actual.count_as_target);
+    EXPECT_EQ(expected.target_offsets, actual.target_offsets);
+    EXPECT_EQ(expected.target_enums, actual.target_enums);
+}
+
+TEST(DigraphTest, TestGraphCache) {
+    std::string filename = write_temporary("car\tvehicle\nbus\tvehicle\nvehicle\tthing\n");
+    std::string cache = testing::TempDir() + "digraph_test.cache";
+    std::remove(cache.c_str());
+    set_mtime(filename, 1000000000);
+    poincare::Digraph parsed(filename, 1);
+    poincare::Digraph written(filename, 1, cache);
+    expect_same_graph(parsed, written);
+    poincare::Digraph read(filename, 1, cache);
+    expect_same_graph(parsed, read);
+
+    // rewriting the file with the same size and modification time is not
+    // noticed, which shows that the cache is used
+    write_temporary("vehicle\tthing\ncar\tvehicle\nbus\tvehicle\n");
+    set_mtime(filename, 1000000000);
+    poincare::Digraph stale(filename, 1, cache);
+    expect_same_graph(parsed, stale);
+
+    // but with another modification time, the cache is rebuilt
+    set_mtime(filename, 1000000001);
+    poincare::Digraph rebuilt(filename, 1, cache);
+    poincare::Digraph reparsed(filename, 1);
+    EXPECT_EQ("vehicle", reparsed.names.name(0));
+    expect_same_graph(reparsed, rebuilt);
+    poincare::Digraph reread(filename, 1, cache);
+    expect_same_graph(reparsed, reread);
+    std::remove(filename.c_str());
+    std::remove(cache.c_str());
+}
+
+TEST(DigraphTest, TestTruncatedGraphCacheIsRebuilt) {
+    std::string filename = write_temporary(large_graph());
+    std::string cache = testing::TempDir() + "digraph_test.cache";
+    std::remove(cache.c_str());
+    poincare::Digraph parsed(filename, 1);
+    poincare::Digraph written(filename, 1, cache);
+    std::ifstream in(cache, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    for (int64_t size : {int64_t(0), int64_t(20), int64_t(contents.size() / 2), int64_t(contents.size() - 1)}) {
+        std::ofstream out(cache, std::ios::binary);
+        out << contents.substr(0, size);
+        out.close();
+        poincare::Digraph rebuilt(filename, 1, cache);
+        expect_same_graph(parsed, rebuilt);
+    }
+    std::remove(filename.c_str());
+    std::remove(cache.c_str());
+}
+
 }    // namespace
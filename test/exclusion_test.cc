@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+#include "exclusion.h"
+#include "sampler.h"
+#include <algorithm>
+#include <random>
+#include <sstream>
+
+namespace {
+
+using poincare::Digraph;
+using poincare::ExclusionIndex;
+using poincare::node_t;
+using poincare::RejectionStats;
+
+// a random graph on `nodes` nodes, where node n has about n targets (some
+// repeated)
+std::string random_graph(int nodes) {
+    std::minstd_rand rng(5);
+    std::ostringstream out;
+    for (int i = 0; i < nodes; i++) {
+        for (int j = 0; j < i; j++) {
+            out << "node" << i << "\tnode" << rng() % nodes << "\n";
+        }
+    }
+    return out.str();
+}
+
+void check_matches_targets(int64_t filter_degree) {
+    std::istringstream in(random_graph(200));
+    Digraph digraph(in);
+    ExclusionIndex exclusions(digraph, filter_degree);
+    for (node_t source = 0; source < digraph.node_count(); source++) {
+        std::vector<node_t> targets(digraph.target_enums.begin() + digraph.target_offsets[source],
+                                     digraph.target_enums.begin() + digraph.target_offsets[source + 1]);
+        for (node_t node = 0; node < digraph.node_count(); node++) {
+            bool is_target = std::find(targets.begin(), targets.end(), node) != targets.end();
+            ASSERT_EQ(is_target, exclusions.excludes(source, node));
+        }
+    }
+}
+
+TEST(ExclusionIndexTest, matchesTargetsWithoutFilters) {
+    check_matches_targets(1000000);
+}
+
+TEST(ExclusionIndexTest, matchesTargetsWithFilters) {
+    check_matches_targets(1);
+    check_matches_targets(50);
+}
+
+TEST(ExclusionIndexTest, filtersHighDegreeNodesOnly) {
+    std::istringstream in(random_graph(100));
+    Digraph digraph(in);
+    ExclusionIndex unfiltered(digraph, 1000);
+    ExclusionIndex filtered(digraph, 40);
+    EXPECT_EQ(0, unfiltered.filtered_nodes());
+    int64_t high_degree = 0;
+    for (node_t n = 0; n < digraph.node_count(); n++) {
+        std::vector<node_t> targets(digraph.target_enums.begin() + digraph.target_offsets[n],
+                                     digraph.target_enums.begin() + digraph.target_offsets[n + 1]);
+        std::sort(targets.begin(), targets.end());
+        high_degree += std::unique(targets.begin(), targets.end()) - targets.begin() >= 40;
+    }
+    EXPECT_EQ(high_degree, filtered.filtered_nodes());
+    EXPECT_GT(filtered.bytes(), unfiltered.bytes());
+}
+
+TEST(ExclusionIndexTest, samplerRejectsTargets) {
+    std::istringstream in("a\tb\na\tc\nb\tc\nc\td\n");
+    Digraph digraph(in);
+    ExclusionIndex exclusions(digraph, 1);
+    std::vector<int64_t> counts = {1, 1, 1, 1};
+    poincare::Sampler sampler(1.0, counts);
+    poincare::Rng rng(0);
+    RejectionStats stats;
+    const node_t a = digraph.names.at("a");
+    for (int i = 0; i < 1000; i++) {
+        node_t sample = sampler.get_sample(exclusions, a, rng, stats);
+        EXPECT_FALSE(exclusions.excludes(a, sample));
+    }
+    EXPECT_EQ(1000, stats.samples);
+    // half of the weight is excluded
+    EXPECT_NEAR(1000, stats.rejections, 150);
+    EXPECT_GT(stats.max_rejections, 0);
+}
+
+}
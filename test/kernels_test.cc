@@ -0,0 +1,175 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "kernels.h"
+#include "real.h"
+
+namespace {
+
+const poincare::Isa ALL_ISAS[] = {poincare::Isa::SCALAR, poincare::Isa::AVX2, poincare::Isa::AVX512};
+
+template <typename T>
+class KernelsTest : public ::testing::Test {
+    protected:
+        // fill x and y with random entries, also recording them at the reference precision
+        void fill(int64_t n, std::minstd_rand& rng) {
+            std::uniform_real_distribution<double> uniform(-2, 2);
+            x.resize(n);
+            y.resize(n);
+            x_ref.resize(n);
+            y_ref.resize(n);
+            for (int64_t i = 0; i < n; i++) {
+                x[i] = uniform(rng);
+                y[i] = uniform(rng);
+                x_ref[i] = x[i];
+                y_ref[i] = y[i];
+            }
+        }
+
+        // tolerance for a sum of n products of entries of magnitude at most 2
+        real tolerance(int64_t n) {
+            return 4 * n * 8 * std::numeric_limits<T>::epsilon();
+        }
+
+        std::vector<T> x, y;
+        std::vector<real> x_ref, y_ref;
+};
+
+typedef ::testing::Types<float, double, long double> Precisions;
+TYPED_TEST_CASE(KernelsTest, Precisions);
+
+TYPED_TEST(KernelsTest, ScalarAlwaysAvailable) {
+    EXPECT_TRUE(poincare::kernels_for<TypeParam>(poincare::Isa::SCALAR) != nullptr);
+}
+
+TYPED_TEST(KernelsTest, ReductionsMatchReference) {
+    std::minstd_rand rng(1);
+    for (poincare::Isa isa : ALL_ISAS) {
+        const poincare::Kernels<TypeParam>* k = poincare::kernels_for<TypeParam>(isa);
+        if (k == nullptr) {
+            continue;
+        }
+        SCOPED_TRACE(poincare::isa_name(isa));
+        // cover the unrolled, vector and remainder loops
+        for (int64_t n = 1; n < 70; n++) {
+            this->fill(n, rng);
+            real dot_ref = 0;
+            real dist_ref = 0;
+            for (int64_t i = 0; i < n; i++) {
+                dot_ref += this->x_ref[i] * this->y_ref[i];
+                dist_ref += (this->x_ref[i] - this->y_ref[i]) * (this->x_ref[i] - this->y_ref[i]);
+            }
+            real mdp_ref = dot_ref - 2 * this->x_ref[n - 1] * this->y_ref[n - 1];
+            EXPECT_NEAR(dot_ref, k->dot(this->x.data(), this->y.data(), n), this->tolerance(n));
+            EXPECT_NEAR(mdp_ref, k->minkowski_dot(this->x.data(), this->y.data(), n), this->tolerance(n));
+            EXPECT_NEAR(dist_ref, k->squared_dist(this->x.data(), this->y.data(), n), 4 * this->tolerance(n));
+        }
+    }
+}
+
+TYPED_TEST(KernelsTest, UpdatesMatchReference) {
+    std::minstd_rand rng(2);
+    for (poincare::Isa isa : ALL_ISAS) {
+        const poincare::Kernels<TypeParam>* k = poincare::kernels_for<TypeParam>(isa);
+        if (k == nullptr) {
+            continue;
+        }
+        SCOPED_TRACE(poincare::isa_name(isa));
+        for (int64_t n = 1; n < 70; n++) {
+            this->fill(n, rng);
+            // write beyond the end, to check nothing is written there
+            this->x.push_back(7);
+            this->y.push_back(7);
+            k->scale(this->x.data(), (TypeParam) 1.5, n);
+            k->axpy(this->y.data(), (TypeParam) -0.5, this->x.data(), n);
+            for (int64_t i = 0; i < n; i++) {
+                real x_ref = this->x_ref[i] * (TypeParam) 1.5;
+                EXPECT_NEAR(x_ref, this->x[i], this->tolerance(1));
+                EXPECT_NEAR(this->y_ref[i] + (TypeParam) -0.5 * x_ref, this->y[i], this->tolerance(1));
+            }
+            EXPECT_EQ(7, this->x[n]);
+            EXPECT_EQ(7, this->y[n]);
+        }
+    }
+}
+
+TYPED_TEST(KernelsTest, FusedUpdatesMatchReference) {
+    std::minstd_rand rng(3);
+    for (poincare::Isa isa : ALL_ISAS) {
+        const poincare::Kernels<TypeParam>* k = poincare::kernels_for<TypeParam>(isa);
+        if (k == nullptr) {
+            continue;
+        }
+        SCOPED_TRACE(poincare::isa_name(isa));
+        for (int64_t n = 1; n < 70; n++) {
+            this->fill(n, rng);
+            std::vector<TypeParam> y(this->y);
+            std::vector<TypeParam> z(this->x);
+            y.push_back(7);
+            z.push_back(7);
+            TypeParam norm = k->axpby(this->y.data(), (TypeParam) 0.5, (TypeParam) -1.5, this->x.data(), n);
+            TypeParam accumulated_norm = k->accumulate_axpby(z.data(), (TypeParam) 2, y.data(),
+                                                             (TypeParam) 0.5, (TypeParam) -1.5, this->x.data(), n);
+            real norm_ref = 0;
+            for (int64_t i = 0; i < n; i++) {
+                real y_ref = 0.5 * this->y_ref[i] - 1.5 * this->x_ref[i];
+                norm_ref += y_ref * y_ref;
+                EXPECT_NEAR(y_ref, this->y[i], this->tolerance(2));
+                EXPECT_NEAR(y_ref, y[i], this->tolerance(2));
+                EXPECT_NEAR(this->x_ref[i] + 2 * this->y_ref[i], z[i], this->tolerance(2));
+            }
+            EXPECT_NEAR(norm_ref, norm, 4 * this->tolerance(n));
+            EXPECT_NEAR(norm_ref, accumulated_norm, 4 * this->tolerance(n));
+            EXPECT_EQ(7, y[n]);
+            EXPECT_EQ(7, z[n]);
+        }
+    }
+}
+
+TYPED_TEST(KernelsTest, MinkowskiGemmMatchesReference) {
+    std::minstd_rand rng(4);
+    std::uniform_real_distribution<double> uniform(-2, 2);
+    for (poincare::Isa isa : ALL_ISAS) {
+        const poincare::Kernels<TypeParam>* k = poincare::kernels_for<TypeParam>(isa);
+        if (k == nullptr) {
+            continue;
+        }
+        SCOPED_TRACE(poincare::isa_name(isa));
+        // cover the blocks of rows and of columns, and the remainders of each
+        for (int64_t rows : {1, 4, 7}) {
+            for (int64_t m : {1, 5, 16, 21}) {
+                for (int64_t n : {2, 11, 17}) {
+                    std::vector<TypeParam> a(rows * n), b(n * m);
+                    for (TypeParam& entry : a) {
+                        entry = uniform(rng);
+                    }
+                    for (TypeParam& entry : b) {
+                        entry = uniform(rng);
+                    }
+                    // write beyond the end, to check nothing is written there
+                    std::vector<TypeParam> c(rows * m + 1, 7);
+                    k->minkowski_gemm(c.data(), a.data(), rows, b.data(), m, n);
+                    for (int64_t i = 0; i < rows; i++) {
+                        for (int64_t j = 0; j < m; j++) {
+                            real mdp_ref = -real(a[i * n + n - 1]) * b[(n - 1) * m + j];
+                            for (int64_t l = 0; l < n - 1; l++) {
+                                mdp_ref += real(a[i * n + l]) * b[l * m + j];
+                            }
+                            EXPECT_NEAR(mdp_ref, c[i * m + j], this->tolerance(n));
+                        }
+                    }
+                    EXPECT_EQ(7, c[rows * m]);
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(KernelsTest, DispatchChoosesSupportedIsa) {
+    const poincare::Kernels<TypeParam>& k = poincare::kernels<TypeParam>();
+    EXPECT_TRUE(poincare::isa_supported(k.isa));
+    EXPECT_EQ(&k, poincare::kernels_for<TypeParam>(k.isa));
+}
+
+}    // namespace
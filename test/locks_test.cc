@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "locks.h"
+#include <thread>
+#include <vector>
+
+namespace {
+
+using poincare::LockTable;
+using poincare::LockTableMode;
+
+const LockTableMode ALL_MODES[] = {LockTableMode::BIT, LockTableMode::BYTE, LockTableMode::STRIPED};
+
+TEST(LockTableTest, tryLockFailsWhileHeld) {
+    for (LockTableMode mode : ALL_MODES) {
+        LockTable locks(100, mode, 16);
+        for (int64_t node = 0; node < 100; node += 7) {
+            int64_t slot = locks.slot(node);
+            EXPECT_TRUE(locks.try_lock(slot));
+            EXPECT_FALSE(locks.try_lock(slot));
+            locks.unlock(slot);
+            EXPECT_TRUE(locks.try_lock(slot));
+            locks.unlock(slot);
+        }
+    }
+}
+
+TEST(LockTableTest, nodesHaveIndependentLocks) {
+    for (LockTableMode mode : {LockTableMode::BIT, LockTableMode::BYTE}) {
+        LockTable locks(130, mode, 0);
+        // lock every other node (crossing the words of the bit table)
+        for (int64_t node = 0; node < 130; node += 2) {
+            EXPECT_TRUE(locks.try_lock(locks.slot(node)));
+        }
+        for (int64_t node = 1; node < 130; node += 2) {
+            EXPECT_TRUE(locks.try_lock(locks.slot(node)));
+        }
+        for (int64_t node = 0; node < 130; node++) {
+            EXPECT_FALSE(locks.try_lock(locks.slot(node)));
+        }
+    }
+}
+
+TEST(LockTableTest, stripesAreShared) {
+    LockTable locks(100, LockTableMode::STRIPED, 16);
+    EXPECT_EQ(locks.slot(3), locks.slot(19));
+    EXPECT_NE(locks.slot(3), locks.slot(4));
+    EXPECT_TRUE(locks.try_lock(locks.slot(3)));
+    EXPECT_FALSE(locks.try_lock(locks.slot(19)));
+    EXPECT_TRUE(locks.try_lock(locks.slot(4)));
+}
+
+TEST(LockTableTest, sizes) {
+    EXPECT_EQ(16, LockTable(65, LockTableMode::BIT, 0).bytes());
+    EXPECT_EQ(65, LockTable(65, LockTableMode::BYTE, 0).bytes());
+    EXPECT_EQ(4 * 64, LockTable(65, LockTableMode::STRIPED, 4).bytes());
+    EXPECT_THROW(LockTable(65, LockTableMode::STRIPED, 0), std::invalid_argument);
+}
+
+TEST(LockTableTest, mutualExclusion) {
+    for (LockTableMode mode : ALL_MODES) {
+        // threads increment counters under the lock of their node; with
+        // mutual exclusion, no increments are lost
+        const int64_t nodes = 8;
+        LockTable locks(nodes, mode, 3);
+        std::vector<int64_t> counters(nodes, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.push_back(std::thread([&locks, &counters, t]() {
+                for (int i = 0; i < 20000; i++) {
+                    int64_t node = (i + t) % nodes;
+                    int64_t slot = locks.slot(node);
+                    while (!locks.try_lock(slot)) {
+                        std::this_thread::yield();
+                    }
+                    counters[node]++;
+                    locks.unlock(slot);
+                }
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (int64_t node = 0; node < nodes; node++) {
+            EXPECT_EQ(4 * 20000 / nodes, counters[node]);
+        }
+    }
+}
+
+}
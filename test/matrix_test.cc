@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+#include "matrix.h"
+#include "real.h"
+#include "vector.h"
+
+namespace {
+
+TEST(MatrixTest, RowsAreAlignedAndPadded) {
+    poincare::Matrix<real> matrix(7, 3);
+    EXPECT_EQ(matrix.size(), 7);
+    EXPECT_EQ(matrix.cols(), 3);
+    EXPECT_EQ(matrix.stride() * sizeof(real) % poincare::ROW_ALIGNMENT, 0u);
+    EXPECT_GE(matrix.stride(), matrix.cols());
+    for (int64_t i = 0; i < matrix.size(); i++) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(matrix.row(i)) % poincare::ROW_ALIGNMENT, 0u);
+        for (int64_t j = 0; j < matrix.stride(); j++) {
+            EXPECT_EQ(matrix.row(i)[j], 0.);
+        }
+    }
+}
+
+TEST(MatrixTest, HugePages) {
+    poincare::Matrix<real> matrix(1000, 11, true);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(matrix.row(0)) % poincare::ROW_ALIGNMENT, 0u);
+    matrix.row(999)[10] = 2.;
+    EXPECT_EQ(matrix.row(999)[10], 2.);
+    EXPECT_EQ(matrix.row(998)[10], 0.);
+}
+
+TEST(MatrixTest, RowViewWritesThrough) {
+    poincare::Matrix<real> matrix(2, 2);
+    poincare::Vector<real> view(matrix.row(1), matrix.cols());
+    view[0] = 0.;
+    view[1] = 1.;
+    view.multiply(2.);
+    EXPECT_EQ(matrix.row(1)[1], 2.);
+    EXPECT_EQ(matrix.row(0)[1], 0.);
+
+    // assignment copies into the row
+    poincare::Vector<real> other(2);
+    other[0] = 3.;
+    view = other;
+    EXPECT_EQ(matrix.row(1)[0], 3.);
+    EXPECT_EQ(view.data_, matrix.row(1));
+
+    // copying a view gives an independent vector
+    poincare::Vector<real> copy(view);
+    copy[0] = 4.;
+    EXPECT_EQ(matrix.row(1)[0], 3.);
+}
+
+}    // namespace
@@ -0,0 +1,378 @@
+#include "gtest/gtest.h"
+#include "model.h"
+#include "allocation_counter.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+using poincare::Args;
+using poincare::Matrix;
+using poincare::Model;
+using poincare::node_t;
+using poincare::Vector;
+
+template <typename T>
+std::shared_ptr<Matrix<T>> random_vectors(int64_t rows, int dimension) {
+    std::shared_ptr<Matrix<T>> vectors = std::make_shared<Matrix<T>>(rows, dimension + 1);
+    std::minstd_rand rng(7);
+    for (int64_t i = 0; i < rows; i++) {
+        Vector<T> row(vectors->row(i), dimension + 1);
+        poincare::random_hyperboloid_point(row, rng, 0.1);
+    }
+    return vectors;
+}
+
+std::shared_ptr<Args> model_args(int dimension, int number_negatives, bool additive_updates,
+                                 bool lock_free = false) {
+    std::shared_ptr<Args> args = std::make_shared<Args>();
+    args->dimension = dimension;
+    args->number_negatives = number_negatives;
+    args->additive_updates = additive_updates;
+    args->lock_free = lock_free;
+    return args;
+}
+
+// Draw distinct samples other than the source, as obtained for training
+// (which never updates a vector twice for the same edge).
+void draw_samples(std::minstd_rand& rng, int64_t rows, int number_negatives,
+                  node_t source, std::vector<node_t>& samples) {
+    std::uniform_int_distribution<node_t> node(0, rows - 1);
+    samples.clear();
+    while (samples.size() < size_t(number_negatives) + 1) {
+        node_t sample = node(rng);
+        if (sample != source && std::find(samples.begin(), samples.end(), sample) == samples.end()) {
+            samples.push_back(sample);
+        }
+    }
+}
+
+// Draw a random source and samples for it, as above.
+void draw_edge(std::minstd_rand& rng, int64_t rows, int number_negatives,
+               node_t& source, std::vector<node_t>& samples) {
+    std::uniform_int_distribution<node_t> node(0, rows - 1);
+    source = node(rng);
+    draw_samples(rng, rows, number_negatives, source, samples);
+}
+
+// Train the same samples with the model chosen by create_model and with the
+// generic model, and check that they agree.
+void check_matches_generic(int dimension, int number_negatives, bool additive_updates) {
+    const int64_t rows = 64;
+    std::shared_ptr<Args> args = model_args(dimension, number_negatives, additive_updates);
+    auto fixed_vectors = random_vectors<double>(rows, dimension);
+    auto generic_vectors = random_vectors<double>(rows, dimension);
+    auto fixed = poincare::create_model(fixed_vectors, args);
+    Model<double> generic(generic_vectors, args);
+
+    std::minstd_rand rng(11);
+    node_t source;
+    std::vector<node_t> samples;
+    for (int step = 0; step < 100; step++) {
+        draw_edge(rng, rows, number_negatives, source, samples);
+        fixed->nickel_kiela_objective(source, samples, 0.1);
+        generic.nickel_kiela_objective(source, samples, 0.1);
+    }
+    for (int64_t i = 0; i < rows; i++) {
+        for (int j = 0; j < dimension + 1; j++) {
+            EXPECT_NEAR(generic_vectors->row(i)[j], fixed_vectors->row(i)[j], 1e-9);
+        }
+    }
+    EXPECT_NEAR(generic.get_performance(), fixed->get_performance(), 1e-9);
+}
+
+TEST(ModelTest, specialisedMatchesGenericLowDimension) {
+    check_matches_generic(2, 10, false);
+    check_matches_generic(10, 20, false);
+}
+
+TEST(ModelTest, specialisedMatchesGenericHighDimension) {
+    check_matches_generic(100, 10, false);
+}
+
+TEST(ModelTest, specialisedMatchesGenericAdditiveUpdates) {
+    check_matches_generic(5, 10, true);
+}
+
+TEST(ModelTest, specialisedModelFallsBackForOtherSampleCounts) {
+    // a specialised model given fewer samples than it was compiled for
+    const int64_t rows = 16;
+    std::shared_ptr<Args> args = model_args(2, 10, false);
+    auto vectors = random_vectors<double>(rows, 2);
+    auto model = poincare::create_model(vectors, args);
+    std::vector<node_t> samples = {1, 2, 3};
+    model->nickel_kiela_objective(0, samples, 0.1);
+    for (int64_t i = 0; i < rows; i++) {
+        EXPECT_NEAR(-1., poincare::minkowski_dot(Vector<double>(vectors->row(i), 3),
+                                                  Vector<double>(vectors->row(i), 3)), 1e-9);
+    }
+}
+
+// Train the same samples lock-free, with the vectors stored on the ball, and
+// with locking, with the vectors stored on the hyperboloid, and check that
+// they agree.
+void check_lock_free_matches_locking(int dimension, int number_negatives, bool additive_updates) {
+    const int64_t rows = 64;
+    auto ball_vectors = random_vectors<double>(rows, dimension);
+    auto hyperboloid_vectors = random_vectors<double>(rows, dimension);
+    for (int64_t i = 0; i < rows; i++) {
+        Vector<double>(ball_vectors->row(i), dimension + 1).to_ball_point();
+    }
+    auto lock_free = poincare::create_model(ball_vectors, model_args(dimension, number_negatives, additive_updates, true));
+    auto locking = poincare::create_model(hyperboloid_vectors, model_args(dimension, number_negatives, additive_updates));
+
+    std::minstd_rand rng(17);
+    node_t source;
+    std::vector<node_t> samples;
+    for (int step = 0; step < 100; step++) {
+        draw_edge(rng, rows, number_negatives, source, samples);
+        lock_free->nickel_kiela_objective(source, samples, 0.1);
+        locking->nickel_kiela_objective(source, samples, 0.1);
+    }
+    for (int64_t i = 0; i < rows; i++) {
+        Vector<double> expected(Vector<double>(hyperboloid_vectors->row(i), dimension + 1));
+        expected.to_ball_point();
+        for (int j = 0; j < dimension + 1; j++) {
+            EXPECT_NEAR(expected[j], ball_vectors->row(i)[j], 1e-9);
+        }
+    }
+}
+
+TEST(ModelTest, lockFreeMatchesLocking) {
+    check_lock_free_matches_locking(2, 10, false);
+    check_lock_free_matches_locking(7, 9, false);
+    check_lock_free_matches_locking(5, 10, true);
+}
+
+TEST(ModelTest, lockFreePullsBackTornReads) {
+    // a vector outside the ball, as could be read while being written
+    const int64_t rows = 4;
+    auto vectors = random_vectors<double>(rows, 2);
+    for (int64_t i = 0; i < rows; i++) {
+        Vector<double>(vectors->row(i), 3).to_ball_point();
+    }
+    vectors->row(0)[0] = 0.9;
+    vectors->row(0)[1] = 0.9;
+    auto model = poincare::create_model(vectors, model_args(2, 2, false, true));
+    std::vector<node_t> samples = {1, 2, 3};
+    model->nickel_kiela_objective(0, samples, 0.1);
+    for (int64_t i = 0; i < rows; i++) {
+        Vector<double> row(vectors->row(i), 3);
+        EXPECT_LT(row.squared_norm(), 1);
+        EXPECT_EQ(0, row[2]);
+    }
+}
+
+// Train groups of edges from random sources with group_edge, and the same
+// edges with nickel_kiela_objective, and check that they agree.
+void check_groups_match_edges(int dimension, int number_negatives, int group_size,
+                              bool per_edge_source_updates, bool lock_free) {
+    const int64_t rows = 64;
+    std::shared_ptr<Args> args = model_args(dimension, number_negatives, false, lock_free);
+    args->per_edge_source_updates = per_edge_source_updates;
+    auto grouped_vectors = random_vectors<double>(rows, dimension);
+    auto edge_vectors = random_vectors<double>(rows, dimension);
+    if (lock_free) {
+        for (int64_t i = 0; i < rows; i++) {
+            Vector<double>(grouped_vectors->row(i), dimension + 1).to_ball_point();
+            Vector<double>(edge_vectors->row(i), dimension + 1).to_ball_point();
+        }
+    }
+    auto grouped = poincare::create_model(grouped_vectors, args);
+    auto edges = poincare::create_model(edge_vectors, args);
+
+    std::minstd_rand rng(19);
+    std::uniform_int_distribution<node_t> node(0, rows - 1);
+    std::vector<node_t> samples;
+    for (int group = 0; group < 50; group++) {
+        node_t source = node(rng);
+        grouped->begin_group(source);
+        for (int edge = 0; edge < group_size; edge++) {
+            draw_samples(rng, rows, number_negatives, source, samples);
+            grouped->group_edge(samples, 0.1);
+            edges->nickel_kiela_objective(source, samples, 0.1);
+        }
+        grouped->end_group();
+    }
+    for (int64_t i = 0; i < rows; i++) {
+        for (int j = 0; j < dimension + 1; j++) {
+            EXPECT_NEAR(edge_vectors->row(i)[j], grouped_vectors->row(i)[j], 1e-9);
+        }
+    }
+}
+
+TEST(ModelTest, groupsWithPerEdgeSourceUpdatesMatchEdges) {
+    // generic and specialised, locking and lock-free
+    for (bool lock_free : {false, true}) {
+        check_groups_match_edges(7, 9, 5, true, lock_free);
+        check_groups_match_edges(10, 10, 5, true, lock_free);
+    }
+}
+
+TEST(ModelTest, groupsOfOneEdgeMatchEdges) {
+    // the single update of the source is then that of the edge
+    for (bool lock_free : {false, true}) {
+        check_groups_match_edges(7, 9, 1, false, lock_free);
+        check_groups_match_edges(10, 10, 1, false, lock_free);
+    }
+}
+
+TEST(ModelTest, groupsUpdateTheSourceOnce) {
+    const int64_t rows = 16;
+    std::shared_ptr<Args> args = model_args(2, 4, false);
+    auto vectors = random_vectors<double>(rows, 2);
+    auto model = poincare::create_model(vectors, args);
+    std::vector<double> before(vectors->row(0), vectors->row(0) + 3);
+    std::minstd_rand rng(23);
+    std::vector<node_t> samples;
+    model->begin_group(0);
+    for (int edge = 0; edge < 8; edge++) {
+        draw_samples(rng, rows, 4, 0, samples);
+        model->group_edge(samples, 0.1);
+        // only the samples have moved
+        for (int j = 0; j < 3; j++) {
+            EXPECT_EQ(before[j], vectors->row(0)[j]);
+        }
+    }
+    model->end_group();
+    EXPECT_NE(before[0], vectors->row(0)[0]);
+    for (int64_t i = 0; i < rows; i++) {
+        EXPECT_NEAR(-1., poincare::minkowski_dot(Vector<double>(vectors->row(i), 3),
+                                                  Vector<double>(vectors->row(i), 3)), 1e-9);
+    }
+}
+
+// Train random edges with nickel_kiela_objective, and the same edges as
+// mini-batches of `copies` copies of the edge, sharing its negatives, at
+// 1 / copies the learning rate, and check that they agree (summing the
+// gradients of each node).
+void check_batches_match_edges(int dimension, int number_negatives, int copies, bool lock_free) {
+    const int64_t rows = 64;
+    auto batch_vectors = random_vectors<double>(rows, dimension);
+    auto edge_vectors = random_vectors<double>(rows, dimension);
+    if (lock_free) {
+        for (int64_t i = 0; i < rows; i++) {
+            Vector<double>(batch_vectors->row(i), dimension + 1).to_ball_point();
+            Vector<double>(edge_vectors->row(i), dimension + 1).to_ball_point();
+        }
+    }
+    std::shared_ptr<Args> args = model_args(dimension, number_negatives, false, lock_free);
+    Model<double> batched(batch_vectors, args);
+    auto edges = poincare::create_model(edge_vectors, args);
+
+    std::minstd_rand rng(29);
+    node_t source;
+    std::vector<node_t> samples;
+    std::vector<uint8_t> excluded(copies * number_negatives, 0);
+    for (int step = 0; step < 50; step++) {
+        draw_edge(rng, rows, number_negatives, source, samples);
+        std::vector<node_t> sources(copies, source);
+        std::vector<node_t> targets(copies, samples[0]);
+        std::vector<node_t> negatives(samples.begin() + 1, samples.end());
+        batched.batch_objective(sources.data(), targets.data(), copies, negatives, excluded, 0.1 / copies);
+        edges->nickel_kiela_objective(source, samples, 0.1);
+    }
+    for (int64_t i = 0; i < rows; i++) {
+        for (int j = 0; j < dimension + 1; j++) {
+            EXPECT_NEAR(edge_vectors->row(i)[j], batch_vectors->row(i)[j], 1e-9);
+        }
+    }
+}
+
+TEST(ModelTest, batchesMatchEdges) {
+    for (bool lock_free : {false, true}) {
+        check_batches_match_edges(7, 9, 1, lock_free);
+        check_batches_match_edges(10, 10, 1, lock_free);
+        check_batches_match_edges(10, 10, 3, lock_free);
+    }
+}
+
+TEST(ModelTest, batchesSkipExcludedNegatives) {
+    // two edges sharing two negatives, of which the second edge excludes one:
+    // the first edge then trains as alone, and the excluded negative only
+    // moves for the first
+    const int64_t rows = 8;
+    std::shared_ptr<Args> args = model_args(3, 2, false);
+    auto batch_vectors = random_vectors<double>(rows, 3);
+    auto edge_vectors = random_vectors<double>(rows, 3);
+    Model<double> batched(batch_vectors, args);
+    Model<double> edges(edge_vectors, args);
+    std::vector<node_t> sources = {0, 1};
+    std::vector<node_t> targets = {2, 3};
+    std::vector<node_t> negatives = {4, 5};
+    std::vector<uint8_t> excluded = {0, 0, 1, 0};
+    batched.batch_objective(sources.data(), targets.data(), 2, negatives, excluded, 0.1);
+    std::vector<node_t> samples = {2, 4, 5};
+    edges.nickel_kiela_objective(0, samples, 0.1);
+    for (node_t node : {0, 2, 4}) {
+        for (int j = 0; j < 4; j++) {
+            EXPECT_NEAR(edge_vectors->row(node)[j], batch_vectors->row(node)[j], 1e-12);
+        }
+    }
+    for (int64_t i = 0; i < rows; i++) {
+        EXPECT_NEAR(-1., poincare::minkowski_dot(Vector<double>(batch_vectors->row(i), 4),
+                                                  Vector<double>(batch_vectors->row(i), 4)), 1e-9);
+    }
+}
+
+// Return the number of allocations made while training `steps` random edges.
+int64_t allocations_while_training(Model<double>& model, int64_t rows, int number_negatives, int steps) {
+    std::minstd_rand rng(13);
+    node_t source;
+    std::vector<node_t> samples;
+    samples.reserve(number_negatives + 1);
+    int64_t before = testing_hooks::allocation_count();
+    for (int step = 0; step < steps; step++) {
+        draw_edge(rng, rows, number_negatives, source, samples);
+        model.nickel_kiela_objective(source, samples, 0.1);
+    }
+    return testing_hooks::allocation_count() - before;
+}
+
+TEST(ModelTest, trainingDoesNotAllocate) {
+    const int64_t rows = 64;
+    for (bool additive_updates : {false, true}) {
+        // generic
+        std::shared_ptr<Args> args = model_args(7, 9, additive_updates);
+        Model<double> generic(random_vectors<double>(rows, 7), args);
+        EXPECT_EQ(0, allocations_while_training(generic, rows, 9, 100));
+        // specialised
+        args = model_args(10, 10, additive_updates);
+        auto specialised = poincare::create_model(random_vectors<double>(rows, 10), args);
+        EXPECT_EQ(0, allocations_while_training(*specialised, rows, 10, 100));
+        // lock-free
+        args = model_args(7, 9, additive_updates, true);
+        auto vectors = random_vectors<double>(rows, 7);
+        for (int64_t i = 0; i < rows; i++) {
+            Vector<double>(vectors->row(i), 8).to_ball_point();
+        }
+        Model<double> lock_free(vectors, args);
+        EXPECT_EQ(0, allocations_while_training(lock_free, rows, 9, 100));
+    }
+}
+
+TEST(ModelTest, batchesDoNotAllocateOnceSized) {
+    const int64_t rows = 64;
+    Model<double> model(random_vectors<double>(rows, 7), model_args(7, 9, false));
+    std::minstd_rand rng(31);
+    std::vector<node_t> sources, targets, negatives;
+    std::vector<uint8_t> excluded(4 * 9, 0);
+    node_t source;
+    std::vector<node_t> samples;
+    for (int b = 0; b < 4; b++) {
+        draw_edge(rng, rows, 9, source, samples);
+        sources.push_back(source);
+        targets.push_back(samples[0]);
+    }
+    negatives.assign(samples.begin() + 1, samples.end());
+    model.batch_objective(sources.data(), targets.data(), 4, negatives, excluded, 0.1);
+    int64_t before = testing_hooks::allocation_count();
+    for (int step = 0; step < 10; step++) {
+        model.batch_objective(sources.data(), targets.data(), 4, negatives, excluded, 0.1);
+    }
+    EXPECT_EQ(0, testing_hooks::allocation_count() - before);
+}
+
+}
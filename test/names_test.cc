@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "names.h"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using poincare::NameTable;
+
+TEST(NameTableTest, numbersNamesInOrderOfInsertion) {
+    NameTable names;
+    EXPECT_EQ(0, names.insert("cat"));
+    EXPECT_EQ(1, names.insert("mammal"));
+    EXPECT_EQ(0, names.insert("cat"));
+    EXPECT_EQ(2, names.insert(""));
+    EXPECT_EQ(3, names.size());
+    EXPECT_EQ("cat", names.name(0));
+    EXPECT_EQ("mammal", names.name(1));
+    EXPECT_EQ("", names.name(2));
+    EXPECT_EQ(6, names.length(1));
+}
+
+TEST(NameTableTest, findsOnlyNamesPresent) {
+    NameTable names;
+    names.insert("cat");
+    names.insert("catalogue");
+    EXPECT_EQ(0, names.find("cat"));
+    EXPECT_EQ(1, names.find("catalogue"));
+    EXPECT_EQ(-1, names.find("ca"));
+    EXPECT_EQ(-1, names.find("catalogues"));
+    // a prefix of a longer buffer
+    EXPECT_EQ(0, names.find("cattle", 3));
+    EXPECT_EQ(1, names.at("catalogue"));
+    EXPECT_THROW(names.at("dog"), std::out_of_range);
+}
+
+TEST(NameTableTest, survivesGrowth) {
+    // enough names to grow the index several times, of lengths either side
+    // of a multiple of eight
+    NameTable names;
+    const int32_t count = 100000;
+    for (int32_t i = 0; i < count; i++) {
+        EXPECT_EQ(i, names.insert("node_" + std::to_string(i)));
+    }
+    EXPECT_EQ(count, names.size());
+    for (int32_t i = 0; i < count; i++) {
+        ASSERT_EQ(i, names.find("node_" + std::to_string(i)));
+        ASSERT_EQ("node_" + std::to_string(i), names.name(i));
+    }
+    EXPECT_EQ(-1, names.find("node_" + std::to_string(count)));
+}
+
+TEST(NameTableTest, reserveKeepsNames) {
+    NameTable names;
+    names.insert("a");
+    names.insert("b");
+    names.reserve(1000);
+    EXPECT_EQ(1, names.find("b"));
+    EXPECT_EQ(2, names.insert("c"));
+}
+
+TEST(NameTableTest, readRebuildsTheIndex) {
+    NameTable names;
+    names.insert("cat");
+    names.insert("dog");
+    std::ostringstream out;
+    names.write(out);
+    std::string contents = out.str();
+    // only the counts and contents of the arena (6 characters) and the
+    // offsets (3) are written
+    EXPECT_EQ(sizeof(int64_t) + 6 + sizeof(int64_t) + 3 * sizeof(int64_t), contents.size());
+    NameTable read;
+    const char* cursor = contents.data();
+    ASSERT_TRUE(read.read(cursor, contents.data() + contents.size()));
+    EXPECT_EQ(contents.data() + contents.size(), cursor);
+    EXPECT_EQ(0, read.find("cat"));
+    EXPECT_EQ(1, read.find("dog"));
+    EXPECT_EQ(-1, read.find("cow"));
+    EXPECT_EQ(2, read.insert("cow"));
+}
+
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "partitions.h"
+#include <limits>
+#include <set>
+#include <sstream>
+
+namespace {
+
+using poincare::Bucket;
+using poincare::Digraph;
+using poincare::PartitionSchedule;
+using poincare::node_t;
+
+// a graph on `nodes` nodes, with an edge from each node to the next few
+std::string chain_graph(int nodes) {
+    std::ostringstream out;
+    for (int i = 0; i < nodes; i++) {
+        for (int j = 1; j <= 3; j++) {
+            out << "node" << i << "\tnode" << (i + j) % nodes << "\n";
+        }
+    }
+    return out.str();
+}
+
+TEST(PartitionScheduleTest, bucketsPartitionTheEdges) {
+    std::istringstream in(chain_graph(50));
+    Digraph digraph(in);
+    PartitionSchedule schedule(digraph, 4);
+    std::vector<int> seen(digraph.edge_count(), 0);
+    for (const Bucket& bucket : schedule.buckets()) {
+        EXPECT_FALSE(bucket.edges.empty());
+        for (int64_t i : bucket.edges) {
+            seen[i]++;
+            EXPECT_EQ(bucket.source_partition, schedule.partition(digraph.edge_sources[i]));
+            EXPECT_EQ(bucket.target_partition, schedule.partition(digraph.edge_targets[i]));
+        }
+    }
+    for (int count : seen) {
+        EXPECT_EQ(1, count);
+    }
+}
+
+TEST(PartitionScheduleTest, roundsAreDisjoint) {
+    std::istringstream in(chain_graph(50));
+    Digraph digraph(in);
+    for (int32_t partitions : {1, 2, 3, 8}) {
+        PartitionSchedule schedule(digraph, partitions);
+        std::vector<int> scheduled(schedule.buckets().size(), 0);
+        for (const std::vector<int32_t>& round : schedule.rounds()) {
+            EXPECT_FALSE(round.empty());
+            std::set<int32_t> busy;
+            for (int32_t b : round) {
+                scheduled[b]++;
+                const Bucket& bucket = schedule.buckets()[b];
+                EXPECT_EQ(0u, busy.count(bucket.source_partition));
+                EXPECT_EQ(0u, busy.count(bucket.target_partition));
+                busy.insert(bucket.source_partition);
+                busy.insert(bucket.target_partition);
+            }
+            // largest first
+            for (int64_t i = 1; i < int64_t(round.size()); i++) {
+                EXPECT_GE(schedule.buckets()[round[i - 1]].edges.size(), schedule.buckets()[round[i]].edges.size());
+            }
+        }
+        for (int count : scheduled) {
+            EXPECT_EQ(1, count);
+        }
+    }
+}
+
+TEST(PartitionScheduleTest, partitionsTheWholeEnumeration) {
+    std::istringstream in(chain_graph(10));
+    Digraph digraph(in);
+    PartitionSchedule schedule(digraph, 7);
+    const node_t largest = std::numeric_limits<node_t>::max();
+    EXPECT_EQ(largest % 7, schedule.partition(largest));
+}
+
+TEST(PartitionScheduleTest, invalidPartitions) {
+    std::istringstream in(chain_graph(5));
+    Digraph digraph(in);
+    EXPECT_THROW(PartitionSchedule(digraph, 0), std::invalid_argument);
+}
+
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "random.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using poincare::Rng;
+
+TEST(RngTest, sameSeedSameSequence) {
+    Rng first(42), second(42), other(43);
+    int differences = 0;
+    for (int i = 0; i < 100; i++) {
+        uint64_t value = first();
+        EXPECT_EQ(value, second());
+        differences += value != other();
+    }
+    EXPECT_EQ(100, differences);
+}
+
+TEST(RngTest, seedZeroIsFine) {
+    Rng rng(0);
+    uint64_t ored = 0;
+    for (int i = 0; i < 10; i++) {
+        ored |= rng();
+    }
+    EXPECT_NE(0u, ored);
+}
+
+TEST(RngTest, boundedIsInRangeAndUniform) {
+    Rng rng(1);
+    for (uint32_t range : {1u, 2u, 3u, 7u, 1000u, 4294967295u}) {
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_LT(rng.bounded(range), range);
+        }
+    }
+    const int draws = 300000;
+    std::vector<int> counts(3, 0);
+    for (int i = 0; i < draws; i++) {
+        counts[rng.bounded(3)]++;
+    }
+    for (int count : counts) {
+        EXPECT_NEAR(1. / 3, count * 1. / draws, 5e-3);
+    }
+}
+
+TEST(RngTest, boundedIsUnbiasedForLargeRanges) {
+    // with division, the bottom third of [0, 3 * 2^30) would be drawn twice
+    // as often as the rest from 32 random bits
+    Rng rng(2);
+    const uint32_t range = 3u << 30;
+    const int draws = 300000;
+    int bottom = 0;
+    for (int i = 0; i < draws; i++) {
+        bottom += rng.bounded(range) < (1u << 30);
+    }
+    EXPECT_NEAR(1. / 3, bottom * 1. / draws, 5e-3);
+}
+
+TEST(RngTest, bounded64IsInRangeAndUnbiased) {
+    // ranges beyond 32 bits, as for the enumeration of more than 2^32 nodes
+    Rng rng(3);
+    for (uint64_t range : {uint64_t(1), uint64_t(5) << 32, ~uint64_t(0)}) {
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_LT(rng.bounded64(range), range);
+        }
+    }
+    const uint64_t range = uint64_t(3) << 62;
+    const int draws = 300000;
+    int bottom = 0;
+    for (int i = 0; i < draws; i++) {
+        bottom += rng.bounded64(range) < (uint64_t(1) << 62);
+    }
+    EXPECT_NEAR(1. / 3, bottom * 1. / draws, 5e-3);
+}
+
+TEST(RngTest, worksWithStandardDistributions) {
+    Rng rng(3);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    double sum = 0;
+    for (int i = 0; i < 100000; i++) {
+        double value = uniform(rng);
+        EXPECT_GE(value, 0);
+        EXPECT_LT(value, 1);
+        sum += value;
+    }
+    EXPECT_NEAR(0.5, sum / 100000, 1e-2);
+    std::vector<int> values = {1, 2, 3, 4, 5};
+    std::shuffle(values.begin(), values.end(), rng);
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5}), values);
+}
+
+}
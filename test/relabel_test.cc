@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include "relabel.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using poincare::Digraph;
+using poincare::node_t;
+
+// The transitive closure of a small hierarchy, enumerated cat 0, mammal 1,
+// animal 2, sparrow 3, bird 4, dog 5.
+Digraph animals() {
+    std::istringstream in("cat\tmammal\ncat\tanimal\nsparrow\tbird\nsparrow\tanimal\n"
+                          "mammal\tanimal\ndog\tmammal\ndog\tanimal\nbird\tanimal\n");
+    return Digraph(in);
+}
+
+TEST(RelabelTest, breadthFirstOrder) {
+    EXPECT_EQ(std::vector<node_t>({2, 1, 4, 0, 5, 3}), poincare::breadth_first_order(animals()));
+}
+
+TEST(RelabelTest, depthFirstOrderKeepsSubtreesTogether) {
+    EXPECT_EQ(std::vector<node_t>({2, 1, 0, 5, 4, 3}), poincare::depth_first_order(animals()));
+}
+
+TEST(RelabelTest, degreeOrder) {
+    EXPECT_EQ(std::vector<node_t>({2, 1, 0, 3, 4, 5}), poincare::degree_order(animals()));
+}
+
+TEST(RelabelTest, ordersIncludeNodesOnCycles) {
+    // no roots: a and b are one another's parent
+    std::istringstream in("a\tb\nb\ta\nc\ta\nd\td\n");
+    Digraph digraph(in);
+    for (std::vector<node_t> order : {poincare::breadth_first_order(digraph), poincare::depth_first_order(digraph)}) {
+        std::sort(order.begin(), order.end());
+        EXPECT_EQ(std::vector<node_t>({0, 1, 2, 3}), order);
+    }
+}
+
+TEST(RelabelTest, relabelKeepsTheGraph) {
+    Digraph original = animals();
+    Digraph relabelled = animals();
+    relabelled.relabel(poincare::depth_first_order(relabelled));
+    EXPECT_EQ("animal", relabelled.names.name(0));
+    EXPECT_EQ(0, relabelled.names.find("animal"));
+    ASSERT_EQ(original.edge_count(), relabelled.edge_count());
+    for (int64_t i = 0; i < original.edge_count(); i++) {
+        EXPECT_EQ(original.names.name(original.edge_sources[i]), relabelled.names.name(relabelled.edge_sources[i]));
+        EXPECT_EQ(original.names.name(original.edge_targets[i]), relabelled.names.name(relabelled.edge_targets[i]));
+    }
+    for (node_t n = 0; n < original.node_count(); n++) {
+        const node_t m = relabelled.file_order[n];
+        EXPECT_EQ(original.names.name(n), relabelled.names.name(m));
+        EXPECT_EQ(original.count_as_source[n], relabelled.count_as_source[m]);
+        EXPECT_EQ(original.count_as_target[n], relabelled.count_as_target[m]);
+    }
+    // relabelling again keeps track of the file order
+    relabelled.relabel(poincare::degree_order(relabelled));
+    for (node_t n = 0; n < original.node_count(); n++) {
+        EXPECT_EQ(original.names.name(n), relabelled.names.name(relabelled.file_order[n]));
+    }
+    const node_t mammal = relabelled.names.find("mammal");
+    std::vector<std::string> targets;
+    for (int64_t i = relabelled.target_offsets[mammal]; i < relabelled.target_offsets[mammal + 1]; i++) {
+        targets.push_back(relabelled.names.name(relabelled.target_enums[i]));
+    }
+    EXPECT_EQ(std::vector<std::string>({"animal"}), targets);
+}
+
+}
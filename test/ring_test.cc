@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include "ring.h"
+#include <thread>
+#include <vector>
+
+namespace {
+
+using poincare::node_t;
+using poincare::SampleRing;
+
+TEST(SampleRingTest, roundsCapacityUpToPowerOfTwo) {
+    EXPECT_EQ(1, SampleRing(0, 2).capacity());
+    EXPECT_EQ(8, SampleRing(5, 2).capacity());
+    EXPECT_EQ(16, SampleRing(16, 2).capacity());
+}
+
+TEST(SampleRingTest, popsInOrderUntilEmpty) {
+    SampleRing ring(4, 3);
+    node_t negatives[3] = {7, 8, 9};
+    for (int64_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(ring.try_push(i, node_t(i), node_t(i + 1), negatives, int32_t(i % 4)));
+    }
+    // full
+    EXPECT_FALSE(ring.try_push(4, 0, 0, negatives, 0));
+    EXPECT_EQ(4, ring.size());
+    int64_t position;
+    node_t source, target;
+    node_t popped[3];
+    int32_t count;
+    for (int64_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(ring.try_pop(position, source, target, popped, count));
+        EXPECT_EQ(i, position);
+        EXPECT_EQ(i, source);
+        EXPECT_EQ(i + 1, target);
+        ASSERT_EQ(i % 4, count);
+        for (int32_t j = 0; j < count; j++) {
+            EXPECT_EQ(negatives[j], popped[j]);
+        }
+    }
+    EXPECT_FALSE(ring.try_pop(position, source, target, popped, count));
+    EXPECT_EQ(0, ring.size());
+}
+
+TEST(SampleRingTest, passesEveryEntryBetweenThreads) {
+    const int64_t entries = 200000;
+    SampleRing ring(64, 2);
+    std::thread producer([&]() {
+        for (int64_t i = 0; i < entries; i++) {
+            node_t negatives[2] = {node_t(i % 1000), node_t(i % 1000 + 1)};
+            while (!ring.try_push(i, node_t(i % 1000), 0, negatives, 2)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int64_t position;
+    node_t source, target;
+    node_t negatives[2];
+    int32_t count;
+    for (int64_t i = 0; i < entries; i++) {
+        while (!ring.try_pop(position, source, target, negatives, count)) {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(i, position);
+        ASSERT_EQ(i % 1000, source);
+        ASSERT_EQ(2, count);
+        ASSERT_EQ(source, negatives[0]);
+        ASSERT_EQ(source + 1, negatives[1]);
+    }
+    producer.join();
+}
+
+}
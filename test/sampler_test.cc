@@ -1,26 +1,33 @@
+#include <cmath>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 #include "gtest/gtest.h"
 #include "sampler.h"
+#include "allocation_counter.h"
 
 namespace {
 
+using poincare::node_t;
+
 TEST(SamplerTest, TestTrivial) {
-    std::minstd_rand rng(1);
+    poincare::Rng rng(1);
     std::vector<int64_t> counts = {1};
-    std::vector<int32_t> exclude = {};
-    poincare::Sampler sampler(1.0, counts, 100);
+    std::vector<node_t> exclude = {};
+    poincare::Sampler sampler(1.0, counts);
     for (int i = 0; i < 100; i++) {
-        int32_t sample = sampler.get_sample(exclude, rng);
+        node_t sample = sampler.get_sample(exclude, rng);
         EXPECT_EQ(sample, 0);
     }
 }
 
 TEST(SamplerTest, TestPowerOne) {
-    std::minstd_rand rng(0);
+    poincare::Rng rng(0);
     std::vector<int64_t> counts = {1, 2};
-    std::vector<int32_t> exclude = {};
+    std::vector<node_t> exclude = {};
     int32_t sample_count = 50000;
-    poincare::Sampler sampler(1.0, counts, sample_count);
+    poincare::Sampler sampler(1.0, counts);
     int32_t sum = 0;
     for (int i = 0; i < sample_count; i++) {
         sum += sampler.get_sample(exclude, rng);
@@ -29,11 +36,11 @@ TEST(SamplerTest, TestPowerOne) {
 }
 
 TEST(SamplerTest, TestPowerZeroIsUniform) {
-    std::minstd_rand rng(0);
+    poincare::Rng rng(0);
     std::vector<int64_t> counts = {1, 2};
-    std::vector<int32_t> exclude = {};
+    std::vector<node_t> exclude = {};
     int32_t sample_count = 50000;
-    poincare::Sampler sampler(0.0, counts, sample_count);
+    poincare::Sampler sampler(0.0, counts);
     int32_t sum = 0;
     for (int i = 0; i < sample_count; i++) {
         sum += sampler.get_sample(exclude, rng);
@@ -42,11 +49,11 @@ TEST(SamplerTest, TestPowerZeroIsUniform) {
 }
 
 TEST(SamplerTest, TestFractionalPower) {
-    std::minstd_rand rng(0);
+    poincare::Rng rng(0);
     std::vector<int64_t> counts = {1, 2};
-    std::vector<int32_t> exclude = {};
+    std::vector<node_t> exclude = {};
     int32_t sample_count = 50000;
-    poincare::Sampler sampler(0.75, counts, sample_count);
+    poincare::Sampler sampler(0.75, counts);
     int32_t sum = 0;
     for (int i = 0; i < sample_count; i++) {
         sum += sampler.get_sample(exclude, rng);
@@ -55,11 +62,11 @@ TEST(SamplerTest, TestFractionalPower) {
 }
 
 TEST(SamplerTest, TestProbaZero) {
-    std::minstd_rand rng(0);
+    poincare::Rng rng(0);
     std::vector<int64_t> counts = {0, 1};
-    std::vector<int32_t> exclude = {};
+    std::vector<node_t> exclude = {};
     int32_t sample_count = 500;
-    poincare::Sampler sampler(1, counts, sample_count);
+    poincare::Sampler sampler(1, counts);
     int32_t sum = 0;
     for (int i = 0; i < sample_count; i++) {
         sum += sampler.get_sample(exclude, rng);
@@ -68,23 +75,23 @@ TEST(SamplerTest, TestProbaZero) {
 }
 
 TEST(SamplerTest, TestExclude) {
-    std::minstd_rand rng(0);
+    poincare::Rng rng(0);
     std::vector<int64_t> counts = {3, 2, 3};
-    std::vector<int32_t> exclude = {1};
+    std::vector<node_t> exclude = {1};
     int32_t sample_count = 5000;
-    poincare::Sampler sampler(1.0, counts, sample_count);
+    poincare::Sampler sampler(1.0, counts);
     for (int i = 0; i < sample_count; i++) {
         EXPECT_NE(sampler.get_sample(exclude, rng), 1);
     }
 }
 
 TEST(SamplerTest, TestSeedMakesDifference) {
-    std::minstd_rand rng0(2);
-    std::minstd_rand rng1(1);
+    poincare::Rng rng0(2);
+    poincare::Rng rng1(1);
     std::vector<int64_t> counts = {1, 1};
-    std::vector<int32_t> exclude = {};
+    std::vector<node_t> exclude = {};
     int32_t sample_count = 10000;
-    poincare::Sampler sampler(1.0, counts, sample_count);
+    poincare::Sampler sampler(1.0, counts);
     int32_t coincidence_count = 0;
     for (int i = 0; i < sample_count; i++) {
         coincidence_count += (sampler.get_sample(exclude, rng0) == sampler.get_sample(exclude, rng1));
@@ -92,4 +99,133 @@ TEST(SamplerTest, TestSeedMakesDifference) {
     EXPECT_LT(coincidence_count, sample_count);
 }
 
+TEST(SamplerTest, TestGetSampleDoesNotAllocate) {
+    poincare::Rng rng(0);
+    std::vector<int64_t> counts = {1, 2, 3, 4};
+    std::vector<node_t> exclude = {1, 2};
+    poincare::Sampler sampler(1.0, counts);
+    int64_t before = testing_hooks::allocation_count();
+    for (int i = 0; i < 100; i++) {
+        sampler.get_sample(exclude, rng);
+    }
+    EXPECT_EQ(0, testing_hooks::allocation_count() - before);
+}
+
+// Return the frequency of each outcome among `draws` samples.
+std::vector<double> frequencies(const poincare::Sampler& sampler, int32_t outcomes, int32_t draws) {
+    poincare::Rng rng(3);
+    std::vector<node_t> exclude = {};
+    std::vector<double> frequency(outcomes, 0.);
+    for (int i = 0; i < draws; i++) {
+        frequency[sampler.get_sample(exclude, rng)] += 1. / draws;
+    }
+    return frequency;
+}
+
+TEST(SamplerTest, TestMatchesWeights) {
+    std::vector<int64_t> counts = {1, 0, 7, 3, 1000, 2, 0, 40, 1, 5};
+    for (double power : {1., 0.75, 0.}) {
+        poincare::Sampler sampler(power, counts);
+        std::vector<double> frequency = frequencies(sampler, counts.size(), 1000000);
+        double z = 0;
+        for (int64_t count : counts) {
+            z += pow(count, power);
+        }
+        for (size_t i = 0; i < counts.size(); i++) {
+            EXPECT_NEAR(pow(counts[i], power) / z, frequency[i], 2e-3);
+            if (counts[i] == 0 && power > 0) {
+                EXPECT_EQ(0, frequency[i]);
+            }
+        }
+    }
+}
+
+TEST(SamplerTest, TestWeightsComputedInParallel) {
+    std::vector<int64_t> counts(300000);
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = i % 3;
+    }
+    poincare::Sampler sampler(1.0, counts, 4);
+    std::vector<double> frequency = frequencies(sampler, counts.size(), 100000);
+    double twos = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (counts[i] == 0) {
+            EXPECT_EQ(0, frequency[i]);
+        } else if (counts[i] == 2) {
+            twos += frequency[i];
+        }
+    }
+    EXPECT_NEAR(2. / 3, twos, 1e-2);
+}
+
+TEST(SamplerTest, TestSampleBatchMatchesWeights) {
+    std::istringstream in("a\tb\nb\tc\nc\td\nd\te\n");
+    poincare::Digraph digraph(in);
+    poincare::ExclusionIndex exclusions(digraph, 1);
+    std::vector<int64_t> counts = {1, 2, 3, 4, 10};
+    poincare::Sampler sampler(1.0, counts);
+    poincare::Rng rng(4);
+    poincare::RejectionStats stats;
+    // draw for node "a", whose target "b" is excluded
+    const node_t b = digraph.names.at("b");
+    std::vector<double> frequency(counts.size(), 0.);
+    const int32_t batches = 20000;
+    const int32_t batch = 50;
+    std::vector<node_t> out(batch);
+    for (int i = 0; i < batches; i++) {
+        int64_t budget = 1000000;
+        EXPECT_EQ(batch, sampler.sample_batch(exclusions, digraph.names.at("a"), batch, out.data(),
+                                              rng, stats, budget));
+        for (node_t sample : out) {
+            frequency[sample] += 1. / (batches * batch);
+        }
+    }
+    EXPECT_EQ(0, frequency[b]);
+    for (int32_t n = 0; n < int32_t(counts.size()); n++) {
+        if (n != b) {
+            EXPECT_NEAR(counts[n] / (20. - counts[b]), frequency[n], 2e-3);
+        }
+    }
+    EXPECT_EQ(batches * batch, stats.samples);
+    EXPECT_NEAR(batches * batch * counts[b] / (20. - counts[b]), stats.rejections, 2e3);
+}
+
+TEST(SamplerTest, TestSampleBatchDoesNotAllocate) {
+    std::istringstream in("a\tb\n");
+    poincare::Digraph digraph(in);
+    poincare::ExclusionIndex exclusions(digraph, 1);
+    std::vector<int64_t> counts = {1, 2};
+    poincare::Sampler sampler(1.0, counts);
+    poincare::Rng rng(0);
+    poincare::RejectionStats stats;
+    node_t out[100];
+    int64_t budget = 1000;
+    int64_t before = testing_hooks::allocation_count();
+    sampler.sample_batch(exclusions, 1, 100, out, rng, stats, budget);
+    EXPECT_EQ(0, testing_hooks::allocation_count() - before);
+}
+
+TEST(SamplerTest, TestSampleBatchStopsWhenBudgetRunsOut) {
+    // every outcome of positive weight is a target of "b"
+    std::istringstream in("a\tb\nb\tc\nb\td\n");
+    poincare::Digraph digraph(in);
+    poincare::ExclusionIndex exclusions(digraph, 1);
+    std::vector<int64_t> counts = {0, 0, 1, 1};
+    poincare::Sampler sampler(1.0, counts);
+    poincare::Rng rng(5);
+    poincare::RejectionStats stats;
+    node_t out[10];
+    int64_t budget = 1000;
+    const node_t b = digraph.names.at("b");
+    EXPECT_EQ(0, sampler.sample_batch(exclusions, b, 10, out, rng, stats, budget));
+    EXPECT_EQ(0, budget);
+    EXPECT_EQ(1000, stats.rejections);
+    EXPECT_EQ(0, stats.samples);
+}
+
+TEST(SamplerTest, TestNoPositiveWeight) {
+    std::vector<int64_t> counts = {0, 0};
+    EXPECT_THROW(poincare::Sampler(1.0, counts), std::invalid_argument);
+}
+
 }    // namespace
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "shuffle.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+using poincare::Rng;
+
+// Check that `order` is a permutation of 0, ..., count - 1.
+void expect_permutation(int64_t count, std::vector<int64_t> order) {
+    std::sort(order.begin(), order.end());
+    ASSERT_EQ(count, int64_t(order.size()));
+    for (int64_t i = 0; i < count; i++) {
+        ASSERT_EQ(i, order[i]);
+    }
+}
+
+TEST(ShuffleTest, blockedShuffleKeepsBlocksTogether) {
+    const int64_t count = 1003;
+    const int64_t block = 100;
+    Rng rng(1);
+    std::vector<int64_t> order;
+    poincare::blocked_shuffle(count, block, rng, order);
+    expect_permutation(count, order);
+    // each run of a block's length is one whole block (the short last block
+    // of 3 wherever it falls)
+    int64_t position = 0;
+    int64_t moved = 0;
+    while (position < count) {
+        const int64_t b = order[position] / block;
+        const int64_t length = std::min(count, (b + 1) * block) - b * block;
+        for (int64_t i = position; i < position + length; i++) {
+            ASSERT_EQ(b, order[i] / block);
+            moved += order[i] != i;
+        }
+        position += length;
+    }
+    // and the order is not the identity
+    EXPECT_GT(moved, count / 2);
+}
+
+TEST(ShuffleTest, fullShuffleIsUniform) {
+    // each of the 6 permutations of 3 indices is about equally likely
+    Rng rng(2);
+    std::vector<int64_t> order;
+    std::vector<int> counts(6, 0);
+    const int draws = 60000;
+    for (int i = 0; i < draws; i++) {
+        poincare::blocked_shuffle(3, 3, rng, order);
+        expect_permutation(3, order);
+        counts[order[0] * 2 + (order[1] > order[2])]++;
+    }
+    for (int count : counts) {
+        EXPECT_NEAR(1. / 6, count * 1. / draws, 1e-2);
+    }
+}
+
+TEST(ShuffleTest, sameSeedSameOrder) {
+    Rng first(3), second(3);
+    std::vector<int64_t> first_order, second_order;
+    poincare::blocked_shuffle(500, 64, first, first_order);
+    poincare::blocked_shuffle(500, 64, second, second_order);
+    EXPECT_EQ(first_order, second_order);
+    // and the next epoch differs
+    poincare::blocked_shuffle(500, 64, second, second_order);
+    EXPECT_NE(first_order, second_order);
+}
+
+TEST(ShuffleTest, emptyAndTinyCounts) {
+    Rng rng(4);
+    std::vector<int64_t> order(5, 7);
+    poincare::blocked_shuffle(0, 16, rng, order);
+    EXPECT_TRUE(order.empty());
+    poincare::blocked_shuffle(1, 16, rng, order);
+    EXPECT_EQ(std::vector<int64_t>({0}), order);
+}
+
+}
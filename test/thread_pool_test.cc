@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using poincare::ThreadPool;
+using poincare::WorkQueues;
+
+TEST(ThreadPoolTest, runsTaskOnEveryWorker) {
+    const int32_t workers = 4;
+    ThreadPool pool(workers);
+    EXPECT_EQ(workers, pool.size());
+    std::vector<int32_t> calls(workers, 0);
+    for (int32_t run = 0; run < 50; run++) {
+        pool.run([&](int32_t worker) { calls[worker]++; });
+        // run returns only once every worker has finished
+        for (int32_t worker = 0; worker < workers; worker++) {
+            EXPECT_EQ(run + 1, calls[worker]);
+        }
+    }
+}
+
+TEST(ThreadPoolTest, reusesItsThreads) {
+    const int32_t workers = 3;
+    ThreadPool pool(workers);
+    std::vector<std::thread::id> first(workers), second(workers);
+    pool.run([&](int32_t worker) { first[worker] = std::this_thread::get_id(); });
+    pool.run([&](int32_t worker) { second[worker] = std::this_thread::get_id(); });
+    EXPECT_EQ(first, second);
+}
+
+TEST(WorkQueuesTest, claimsEachIndexOnce) {
+    const int32_t workers = 4;
+    const int64_t total = 10007;
+    ThreadPool pool(workers);
+    WorkQueues queues(workers, total, 64);
+    std::vector<std::atomic<int32_t>> claimed(total);
+    for (int32_t epoch = 0; epoch < 3; epoch++) {
+        queues.reset();
+        pool.run([&](int32_t worker) {
+            int64_t begin, end;
+            while (queues.claim(worker, begin, end)) {
+                for (int64_t i = begin; i < end; i++) {
+                    claimed[i]++;
+                }
+            }
+        });
+        for (int64_t i = 0; i < total; i++) {
+            ASSERT_EQ(epoch + 1, claimed[i].load());
+        }
+    }
+}
+
+TEST(WorkQueuesTest, claimsBeyond32BitIndices) {
+    // more edges than a 32-bit index can count, in large chunks
+    const int64_t total = (int64_t(3) << 32) + 7;
+    WorkQueues queues(3, total, int64_t(1) << 30);
+    std::vector<std::pair<int64_t, int64_t>> claims;
+    int64_t begin, end;
+    for (int32_t worker : {2, 0, 1}) {
+        while (queues.claim(worker, begin, end)) {
+            claims.push_back(std::make_pair(begin, end));
+        }
+    }
+    std::sort(claims.begin(), claims.end());
+    int64_t covered = 0;
+    for (const std::pair<int64_t, int64_t>& claim : claims) {
+        EXPECT_EQ(covered, claim.first);
+        EXPECT_LT(claim.first, claim.second);
+        covered = claim.second;
+    }
+    EXPECT_EQ(total, covered);
+}
+
+TEST(WorkQueuesTest, stealsFromOtherWorkers) {
+    // a single worker claims its own range first, in order, then the others'
+    WorkQueues queues(3, 30, 4);
+    int64_t begin, end;
+    std::vector<int64_t> begins;
+    while (queues.claim(1, begin, end)) {
+        begins.push_back(begin);
+        EXPECT_LE(end - begin, 4);
+    }
+    EXPECT_EQ(std::vector<int64_t>({10, 14, 18, 20, 24, 28, 0, 4, 8}), begins);
+}
+
+}
@@ -8,7 +8,7 @@ namespace {
 
 TEST(VectorTest, init_with_zeros) {
     int m = 5;
-    poincare::Vector vec(m);
+    poincare::Vector<real> vec(m);
     vec.zero();
     EXPECT_EQ(vec.dimension_, m);
     for (auto i = 0; i < vec.dimension_; ++i) {
@@ -17,7 +17,7 @@ TEST(VectorTest, init_with_zeros) {
 }
 
 TEST(VectorTest, multiply) {
-    poincare::Vector vec(2);
+    poincare::Vector<real> vec(2);
     vec[0] = 1.;
     vec[1] = 2.;
     vec.multiply(1.5);
@@ -26,25 +26,25 @@ TEST(VectorTest, multiply) {
 }
 
 TEST(VectorTest, TestDot) {
-    poincare::Vector vec0(2);
+    poincare::Vector<real> vec0(2);
     vec0[0] = 1.;
     vec0[1] = 2.;
-    poincare::Vector vec1(2);
+    poincare::Vector<real> vec1(2);
     vec1[0] = 0.;
     vec1[1] = 4.;
     EXPECT_FLOAT_EQ(8., dot(vec0, vec1));
 }
 
 TEST(VectorTest, TestSquaredNorm) {
-    poincare::Vector vec0(2);
+    poincare::Vector<real> vec0(2);
     vec0[0] = 1.;
     vec0[1] = 2.;
     EXPECT_FLOAT_EQ(5., vec0.squared_norm());
 }
 
 TEST(VectorTest, minkowskiDot) {
-    poincare::Vector vec_a(3);
-    poincare::Vector vec_b(3);
+    poincare::Vector<real> vec_a(3);
+    poincare::Vector<real> vec_b(3);
 
     vec_a[0] = 1.;
     vec_a[1] = 0.5;
@@ -60,8 +60,8 @@ TEST(VectorTest, minkowskiDot) {
 
 TEST(VectorTest, randomHyperboloidPoint) {
     std::minstd_rand rng(1);
-    poincare::Vector vec_a(3);
-    poincare::Vector vec_b(3);
+    poincare::Vector<real> vec_a(3);
+    poincare::Vector<real> vec_b(3);
 
     random_hyperboloid_point(vec_a, rng, 0.1);
     random_hyperboloid_point(vec_b, rng, 0.1);
@@ -73,8 +73,8 @@ TEST(VectorTest, randomHyperboloidPoint) {
 }
 
 TEST(VectorTest, distance) {
-    poincare::Vector vec_a(2);
-    poincare::Vector vec_b(2);
+    poincare::Vector<real> vec_a(2);
+    poincare::Vector<real> vec_b(2);
 
     // basepoint
     vec_a[0] = 0.;
@@ -89,7 +89,7 @@ TEST(VectorTest, distance) {
 }
 
 TEST(VectorTest, ensureOnHyperboloid) {
-    poincare::Vector vec(2);
+    poincare::Vector<real> vec(2);
     
     // almost the basepoint
     vec[0] = 0.;
@@ -102,7 +102,7 @@ TEST(VectorTest, ensureOnHyperboloid) {
 }
 
 TEST(VectorTest, ensureOnHyperboloidNoOp) {
-    poincare::Vector vec(2);
+    poincare::Vector<real> vec(2);
     
     // basepoint: already on the hyperboloid
     vec[0] = 0.;
@@ -114,7 +114,7 @@ TEST(VectorTest, ensureOnHyperboloidNoOp) {
 }
 
 TEST(VectorTest, toBallPointAtBasepoint) {
-    poincare::Vector vec(2);
+    poincare::Vector<real> vec(2);
     // basepoint
     vec[0] = 0.;
     vec[1] = 1.0;
@@ -125,7 +125,7 @@ TEST(VectorTest, toBallPointAtBasepoint) {
 }
 
 TEST(VectorTest, toBallPoint) {
-    poincare::Vector vec(2);
+    poincare::Vector<real> vec(2);
     real dist = 1;
     vec[0] = std::sinh(dist);
     vec[1] = std::cosh(dist);
@@ -136,7 +136,7 @@ TEST(VectorTest, toBallPoint) {
 }
 
 TEST(VectorTest, toHyperboloidPoint) {
-    poincare::Vector vec(3);
+    poincare::Vector<real> vec(3);
     real dist = 1.2;
     vec[0] = 0.;
     vec[1] = std::tanh(dist / 2);
@@ -149,14 +149,14 @@ TEST(VectorTest, toHyperboloidPoint) {
 
 TEST(VectorTest, toBallTangent) {
     // a point on the hyperboloid
-    poincare::Vector point(3);
+    poincare::Vector<real> point(3);
     real dist = 1.2;
     point[0] = std::sinh(dist);
     point[1] = 0.;
     point[2] = std::cosh(dist);
 
     // a unit tangent vector in its tangent space
-    poincare::Vector tangent(3);
+    poincare::Vector<real> tangent(3);
     tangent[0] = 0.;
     tangent[1] = 1.;
     tangent[2] = 0.;
@@ -180,30 +180,30 @@ TEST(VectorTest, toBallTangent) {
 
 TEST(VectorTest, toHyperboloidTangent) {
     // a point on the Poincare disc embedded in Minkowski 2+1 space
-    poincare::Vector ball_point(3);
+    poincare::Vector<real> ball_point(3);
     ball_point[0] = 0.1;
     ball_point[1] = -0.2;
     ball_point[2] = 0;
 
     // a tangent vector in its tangent space
-    poincare::Vector ball_tangent(3);
+    poincare::Vector<real> ball_tangent(3);
     ball_tangent[0] = -0.1;
     ball_tangent[1] = 1.1;
     ball_tangent[2] = 0.;
 
     // get the corresponding hyperboloid point
-    poincare::Vector hyperboloid_point(ball_point);
+    poincare::Vector<real> hyperboloid_point(ball_point);
     hyperboloid_point.to_hyperboloid_point();
 
     // get the tangent
-    poincare::Vector hyperboloid_tangent(ball_tangent);
+    poincare::Vector<real> hyperboloid_tangent(ball_tangent);
     hyperboloid_tangent.to_hyperboloid_tangent(ball_point);
     
     // should be minkowski orthogonal to point
     EXPECT_NEAR(minkowski_dot(hyperboloid_tangent, hyperboloid_point), 0, 1e-8);
 
     // should be undone by to_ball_tangent
-    poincare::Vector tangent(hyperboloid_tangent);
+    poincare::Vector<real> tangent(hyperboloid_tangent);
     tangent.to_ball_tangent(hyperboloid_point);
     for (int i=0; i < tangent.dimension_; i++) {
         EXPECT_NEAR(tangent[i], ball_tangent[i], 1e-8);
@@ -212,14 +212,14 @@ TEST(VectorTest, toHyperboloidTangent) {
 
 TEST(VectorTest, geodesicUpdate) {
     // basepoint
-    poincare::Vector basepoint(2);
+    poincare::Vector<real> basepoint(2);
     basepoint[0] = 0.f;
     basepoint[1] = 1.0f;
     // our test point: start out at the basepoint
-    poincare::Vector point(basepoint);
+    poincare::Vector<real> point(basepoint);
     // a tangent vector in its tangent space
     real dist = 3;
-    poincare::Vector tangent(2);
+    poincare::Vector<real> tangent(2);
     tangent[0] = 1;
     tangent[1] = 0.;
     // apply exponential
@@ -230,10 +230,10 @@ TEST(VectorTest, geodesicUpdate) {
 
 TEST(VectorTest, projectOntoTangentSpace) {
     // basepoint
-    poincare::Vector point(2);
+    poincare::Vector<real> point(2);
     point[0] = 0.;
     point[1] = 1.0;
-    poincare::Vector tangent(2);
+    poincare::Vector<real> tangent(2);
     tangent[0] = 1.5;
     tangent[1] = 1.0;
     tangent.project_onto_tangent_space(point);
@@ -242,4 +242,28 @@ TEST(VectorTest, projectOntoTangentSpace) {
     EXPECT_FLOAT_EQ(0., mdp);
 }
 
+template <typename T>
+class VectorPrecisionTest : public ::testing::Test {};
+
+typedef ::testing::Types<float, double, long double> Precisions;
+TYPED_TEST_CASE(VectorPrecisionTest, Precisions);
+
+TYPED_TEST(VectorPrecisionTest, geodesicUpdateStaysOnHyperboloid) {
+    std::minstd_rand rng(1);
+    poincare::Vector<TypeParam> basepoint(4);
+    basepoint[3] = 1;
+    poincare::Vector<TypeParam> point(4);
+    random_hyperboloid_point(point, rng, 0.1);
+    EXPECT_NEAR(-1., minkowski_dot(point, point), 1e-5);
+    // a unit tangent vector at the point
+    poincare::Vector<TypeParam> tangent(4);
+    tangent[0] = 1;
+    tangent.project_onto_tangent_space(point);
+    tangent.multiply(1 / std::sqrt(minkowski_dot(tangent, tangent)));
+    TypeParam dist_before = distance(basepoint, point);
+    point.geodesic_update(tangent, (TypeParam) 0.5);
+    EXPECT_NEAR(-1., minkowski_dot(point, point), 1e-5);
+    EXPECT_LE(std::abs(distance(basepoint, point) - dist_before), 0.5 + 1e-5);
+}
+
 }    // namespace